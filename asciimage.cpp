@@ -1,162 +1,492 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <string>
 #include <vector>
-#include "winsole/winsole.hpp"
-
+#include "winsole/colors.hpp"
+#include "core/image.hpp"
+#include "core/allocator.hpp"
+#include "core/alpha.hpp"
+#include "core/hdr.hpp"
+#include "core/palette.hpp"
+#include "core/tone.hpp"
+#include "core/glyphs.hpp"
+#include "core/shape.hpp"
+#include "core/exact.hpp"
+#include "core/edges.hpp"
+#include "core/density.hpp"
+#include "core/planes.hpp"
+#include "core/raster.hpp"
+#include "core/encode.hpp"
+#include "core/markup.hpp"
+#include "core/ansi.hpp"
+#include "core/frame.hpp"
+#include "core/cells.hpp"
+#include "platform/console.hpp"
+
+#define STBI_MALLOC(size) image_malloc(size)
+#define STBI_REALLOC(p, size) image_realloc(p, size)
+#define STBI_FREE(p) image_free(p)
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STBIW_ZLIB_COMPRESS png_deflate
 #include "stb/stb_image_write.h"
 
-typedef unsigned char byte;
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb/stb_truetype.h"
 
-struct Pixel
+void lightness_colors(const std::vector<byte> &lightness, const std::array<Color, 256> &color_lut, const std::vector<byte> &opaque, std::vector<Color> &cell_colors)
 {
-    char ch;
-    COLORS colors;
-};
+    cell_colors.resize(lightness.size());
+    for (size_t i = 0; i < lightness.size(); ++i)
+        cell_colors[i] = (opaque.empty() || opaque[i]) ? color_lut[lightness[i]] : AUTO;
+}
 
-struct RGBA
+void palette_colors(const PixelPlanes &planes, const PaletteLUT &lut, const std::vector<byte> &opaque, std::vector<byte> &indices, std::vector<Color> &cell_colors)
 {
-    byte r, g, b, a = 255;
-
-    byte max_value() const { return (r > g ? (r > b ? r : b) : (g > b ? g : b)); }
-    byte min_value() const { return (r < g ? (r < b ? r : b) : (g < b ? g : b)); }
-    float average() const { return (r + g + b) / 3.0f; }
-};
+    cell_colors.resize(planes.pixel_count());
+    indices.resize(planes.width);
+    for (int y = 0; y < planes.height; ++y)
+    {
+        lut.lookup_row(planes.row(CHANNEL_R, y), planes.row(CHANNEL_G, y), planes.row(CHANNEL_B, y), indices.data(), planes.width);
+        Color *out = &cell_colors[size_t(y) * planes.width];
+        const byte *visible = opaque.empty() ? nullptr : &opaque[size_t(y) * planes.width];
+        for (int x = 0; x < planes.width; ++x)
+            out[x] = (!visible || visible[x]) ? static_cast<Color>(indices[x]) : AUTO;
+    }
+}
 
-struct Image
+// Packs text (rows columns + 1 bytes apart, or null for blank cells) and its
+// cell colors into the console grid. Cell colors tint the glyph, or the
+// background in COLOR mode; AUTO cells keep the console's colors from `base`.
+void fill_cells(const char *text, int columns, int rows, const std::vector<Color> &cell_colors, bool color_background, CellAttr base, CellGrid &cells)
 {
-    std::string path;
-    int width, height, bpp, channels;
-    byte *data = nullptr;
-
-    Image() = default;
+    cells.resize(columns, rows);
+    for (int y = 0; y < rows; ++y)
+    {
+        char *glyphs = cells.glyph_row(y);
+        if (text)
+            memcpy(glyphs, text + size_t(y) * (columns + 1), columns);
+        else
+            memset(glyphs, ' ', columns);
+
+        CellAttr *attrs = cells.attr_row(y);
+        const Color *colors = &cell_colors[size_t(y) * columns];
+        for (int x = 0; x < columns; ++x)
+        {
+            if (colors[x] == AUTO)
+                attrs[x] = base;
+            else
+                attrs[x] = color_background ? cell_attr(attr_fg(base), colors[x]) : cell_attr(colors[x], attr_bg(base));
+        }
+    }
+}
 
-    Image(std::string path, int channels = 3) : path(path), channels(channels) {}
+#define version_message "AsciiMage v1.1 (May 2025)\n\n"
+#define DEFAULT_ASCII " ._-3#@"
+#define DEFAULT_COLOR_MAP {BLACK, BLACK, GREY, GREY, BLUE, LIGHT_BLUE, AQUA, LIGHT_AQUA, WHITE, WHITE}
+#define AUTO_COLOR_MAP "AUTO"
+#define DEFAULT_CACHE_MB 64
+#define RENDER_CACHE_PREFIX "asciimage-render-"
 
-    size_t size() const { return width * height * channels; }
-    size_t image_size() const { return width * height; }
+struct Options
+{
+    Tone tone = Tone::NONE;
+    Background background;
+    HdrOptions hdr;
+    std::string font;
+    float font_size = 16.0f;
+    int cell = 0;
+    bool exact = false;
+    bool bench = false;
+    int edges = 0;
+    std::string out;
+    EncodeOptions encode;
+    std::string dump;
+    uint64_t cache_limit = 0;
+    std::string batch;
+    bool fit_auto = true;
+    int fit_columns = 0, fit_rows = 0;
+};
 
-    bool read(std::string rpath = "", int rchannels = 0)
+// Options are given as --name=value and may appear anywhere in the command line.
+bool parse_option(const std::string &arg, Options &options)
+{
+    size_t eq = arg.find('=');
+    std::string name = arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2);
+    std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+    if (name == "tone")
+        return parse_tone(value, options.tone);
+    if (name == "background")
+        return parse_background(value, options.background);
+    if (name == "tonemap")
+        return parse_tonemap(value, options.hdr.tonemap);
+    if (name == "exposure")
+        return parse_exposure(value, options.hdr.exposure);
+    if (name == "font")
     {
-        if (rchannels < 3 || rchannels > 4)
-            rchannels = channels;
-        if (rpath.empty())
-            rpath = path;
-        if (data)
-            stbi_image_free(data);
-
-        data = stbi_load(rpath.c_str(), &width, &height, &bpp, rchannels);
-        if (!data)
-            return false;
-
-        channels = rchannels;
-        return true;
+        options.font = value;
+        return !value.empty();
     }
-
-    void get_color_array(RGBA *&color_array) const
+    if (name == "cell")
+    {
+        options.cell = atoi(value.c_str());
+        return options.cell >= SHAPE_GRID;
+    }
+    if (name == "match")
+    {
+        options.exact = value == "exact";
+        return value == "exact" || value == "shape";
+    }
+    if (name == "edges")
+    {
+        options.edges = value.empty() ? DEFAULT_EDGE_THRESHOLD : atoi(value.c_str());
+        return options.edges > 0;
+    }
+    if (name == "out")
+    {
+        options.out = value;
+        return !value.empty();
+    }
+    if (name == "bench")
+    {
+        options.bench = true;
+        return value.empty();
+    }
+    if (name == "png-level")
+    {
+        options.encode.png.level = atoi(value.c_str());
+        return !value.empty() && options.encode.png.level >= 0 && options.encode.png.level <= 9;
+    }
+    if (name == "png-filter")
+        return parse_png_filter(value, options.encode.png.filter);
+    if (name == "png-strips")
+    {
+        options.encode.png.strips = value.empty() ? static_cast<int>(std::thread::hardware_concurrency()) : atoi(value.c_str());
+        return options.encode.png.strips > 0;
+    }
+    if (name == "format")
+        return parse_image_format(value, options.encode.format);
+    if (name == "quality")
+    {
+        options.encode.jpg_quality = atoi(value.c_str());
+        return options.encode.jpg_quality >= 1 && options.encode.jpg_quality <= 100;
+    }
+    if (name == "dump")
+    {
+        options.dump = value;
+        return !value.empty();
+    }
+    if (name == "fit")
+    {
+        options.fit_auto = value == "auto";
+        options.fit_columns = options.fit_rows = 0;
+        if (options.fit_auto || value == "none")
+            return true;
+        return sscanf(value.c_str(), "%dx%d", &options.fit_columns, &options.fit_rows) == 2 && options.fit_columns > 0 && options.fit_rows > 0;
+    }
+    if (name == "cache")
+    {
+        options.cache_limit = uint64_t(value.empty() ? DEFAULT_CACHE_MB : atoi(value.c_str())) << 20;
+        return options.cache_limit > 0;
+    }
+    if (name == "batch")
+    {
+        options.batch = value;
+        return !value.empty();
+    }
+    if (name == "font-size")
     {
-        if (color_array)
-            delete[] color_array;
-        color_array = new RGBA[image_size()];
-        for (size_t b = 0, color = 0; b < size(); b += channels)
-            color_array[color++] = {data[b], data[b + 1], data[b + 2], (byte)((channels == 4) ? data[b + 3] : 255)};
+        options.font_size = static_cast<float>(atof(value.c_str()));
+        return options.font_size > 0;
     }
+    return false;
+}
+
+// --out for one --batch input: '*' in the pattern becomes the input's file
+// name without directory and extension; a pattern without '*' is appended.
+std::string batch_output(const std::string &pattern, const std::string &input_path)
+{
+    if (pattern.empty())
+        return pattern;
+    size_t slash = input_path.find_last_of("/\\");
+    std::string stem = input_path.substr(slash == std::string::npos ? 0 : slash + 1);
+    stem = stem.substr(0, stem.find_last_of('.'));
+    size_t star = pattern.find('*');
+    return star == std::string::npos ? stem + pattern : pattern.substr(0, star) + stem + pattern.substr(star + 1);
+}
 
-    ~Image()
+// The largest grid --fit allows for this input, 0 where unbounded. auto only
+// bounds console output on a terminal, and only by its width: rows scroll,
+// but a row wider than the window wraps and tears the picture apart. --cell
+// sizes its own grid.
+void fit_limits(ConsoleBackend &console, const Options &options, int &columns, int &rows)
+{
+    columns = rows = 0;
+    if (options.cell)
+        return;
+    if (!options.fit_auto)
     {
-        if (data)
-            stbi_image_free(data);
+        columns = options.fit_columns;
+        rows = options.fit_rows;
     }
-};
+    else if (options.out.empty() && console.capabilities().tty)
+    {
+        columns = console.size().columns;
+    }
+}
+
+// Shrinks width x height into the limits keeping its aspect; false when it
+// already fits.
+bool fit_grid(int width, int height, int max_columns, int max_rows, int &columns, int &rows)
+{
+    double scale = 1.0;
+    if (max_columns && width > max_columns)
+        scale = std::min(scale, double(max_columns) / width);
+    if (max_rows && height > max_rows)
+        scale = std::min(scale, double(max_rows) / height);
+    if (scale >= 1.0)
+        return false;
+    columns = std::max(1, int(width * scale));
+    rows = std::max(1, int(height * scale));
+    return true;
+}
 
-float map(float input, float x1, float x2, float y1, float y2)
+// Output-only options leave the rendered cells alone and are not part of the
+// render cache key. --fit is keyed by the limits it resolves to instead.
+bool changes_render(const std::string &arg)
 {
-    return y1 + (input - x1) * (y2 - y1) / (x2 - x1);
+    const char *output_only[] = {"--out", "--dump", "--bench", "--format", "--quality", "--png-", "--cache", "--batch", "--fit"};
+    for (const char *prefix : output_only)
+        if (arg.compare(0, strlen(prefix), prefix) == 0)
+            return false;
+    return true;
 }
 
-void put_line(Winsole &winsole, int x, int y, const Pixel *line, size_t length)
+// With --font the ramp comes from the font's measured glyph coverage; an
+// explicit map only chooses the candidates, not their order.
+std::array<char, 256> glyph_lut(const Options &options, const std::string &ascii_map, bool custom_map, const ToneCurve &curve)
 {
-    for (size_t i = 0; i < length; ++i)
+    if (!options.font.empty())
     {
-        const Pixel &p = line[i];
-        winsole.set_cursor(x + i, y);
-        winsole.set_color(p.colors.fg, p.colors.bg);
-        winsole.print(p.ch);
+        GlyphRamp ramp;
+        if (calibrated_ramp(options.font, options.font_size, custom_map ? ascii_map : PRINTABLE_ASCII, ramp))
+            return ramp_lut<char>(ramp, ramp.size(), curve);
+        fprintf(stderr, "[!] Failed to load font %s, using the map as given.\n", options.font.c_str());
     }
+    return ramp_lut<char>(ascii_map, ascii_map.length(), curve);
 }
 
-std::string ascii_image(const Image &image, RGBA *&colors, const std::string &ascii_map)
+// Times both --cell matchers on the same input and reports how often they agree.
+void bench_matchers(const std::vector<byte> &lightness, int width, int height, int cell, const GlyphSet &glyph_set, const ToneCurve &curve)
 {
-    std::string ascii_output;
-    ascii_output.reserve(image.image_size() + image.height); // '\n's
-    for (size_t ci = 0, row = 1; ci < image.image_size(); ci++)
+    typedef std::chrono::steady_clock clock;
+    const int runs = 5;
+
+    ShapeMatcher matcher(glyph_set);
+    GlyphAtlas atlas = build_atlas(glyph_set);
+    std::string shape, exact;
+
+    // The first pass also fills the matcher's key table, so it is reported
+    // on its own; later passes only look keys up.
+    auto start = clock::now();
+    shape = shape_ascii_image(lightness.data(), width, height, cell, matcher, curve);
+    double first_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    start = clock::now();
+    for (int i = 0; i < runs; i++)
+        shape = shape_ascii_image(lightness.data(), width, height, cell, matcher, curve);
+    double shape_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count() / runs;
+
+    start = clock::now();
+    for (int i = 0; i < runs; i++)
+        exact = exact_ascii_image(lightness.data(), width, height, cell, atlas, curve);
+    double exact_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count() / runs;
+
+    size_t same = 0, cells = 0;
+    for (size_t i = 0; i < shape.size() && i < exact.size(); i++)
     {
-        byte grey = (colors[ci].max_value() + colors[ci].min_value()) / 2;
-        byte index = map(grey, 0, 255, 0, ascii_map.length() - 1);
-        if (ci >= (row * image.width))
-        {
-            ascii_output += '\n';
-            row++;
-        }
-        ascii_output += ascii_map[index];
+        if (shape[i] == '\n')
+            continue;
+        cells++;
+        same += shape[i] == exact[i];
     }
-    return ascii_output;
+    double per_cell = 1e6 / (cells ? cells : 1);
+    fprintf(stderr, "[bench] %zu cells  shape %.3f ms (%.1f ns/cell, first pass %.1f ns/cell)  exact %.3f ms (%.1f ns/cell)  agreement %.1f%%\n",
+            cells, shape_ms, shape_ms * per_cell, first_ms * per_cell, exact_ms, exact_ms * per_cell, cells ? 100.0 * same / cells : 0.0);
 }
 
-void print_color_image_fast(Winsole &winsole, const Image &image, RGBA *&colors, const std::vector<Color> &colormap)
+// --dump stage: each cell's color looked up in the palette it was printed with.
+bool dump_cell_colors(StageWriter &stages, int width, int height, const std::vector<Color> &cell_colors, const RGBA *palette)
 {
-    size_t w = image.width, h = image.height;
-    std::vector<Pixel> pixels;
-    pixels.reserve(w * h);
+    if (!stages.enabled())
+        return true;
+    size_t cells = size_t(width) * height;
+    std::vector<byte> pixels(cells * 3, 0);
+    for (size_t i = 0; i < cell_colors.size() && i < cells; ++i)
+    {
+        if (cell_colors[i] == AUTO)
+            continue;
+        const RGBA &c = palette[cell_colors[i]];
+        pixels[i * 3] = c.r;
+        pixels[i * 3 + 1] = c.g;
+        pixels[i * 3 + 2] = c.b;
+    }
+    return stages.write("quantized", width, height, 3, pixels.data());
+}
 
-    size_t map_size = colormap.size();
+// Writes a cell grid to --out, by extension: .asf frames, .ans escape text,
+// .html/.svg markup, else an image rendered through the --font glyphs (or
+// the bundled Atari font).
+bool write_cells(const Options &options, const char *glyphs, size_t stride, int columns, int rows, const byte *fg, const byte *bg, const RGBA *palette)
+{
+    std::string extension = options.out.substr(options.out.find_last_of('.') + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (extension == "asf")
+    {
+        std::vector<byte> frame;
+        encode_frame(glyphs, stride, columns, rows, fg, bg, palette, true, frame);
+        return write_file_atomic(options.out, frame.data(), frame.size());
+    }
+    if (extension == "ans" || extension == "html" || extension == "htm" || extension == "svg")
+    {
+        FILE *file = fopen(options.out.c_str(), "wb");
+        if (!file)
+            return false;
+        FileSink sink(file);
+        if (extension == "ans")
+        {
+            // The stock palette maps onto the terminal's own 16 colors.
+            bool stock = memcmp(palette, default_console_palette(), sizeof(RGBA) * CONSOLE_COLORS) == 0;
+            ColorSupport colors = cheapest_colors(palette, stock, ColorSupport::TRUECOLOR);
+            export_ansi(glyphs, stride, columns, rows, fg, bg, palette, colors, FileSink::callback, &sink);
+        }
+        else if (extension == "svg")
+            export_svg(glyphs, stride, columns, rows, fg, bg, palette, CONSOLE_COLORS, FileSink::callback, &sink);
+        else
+            export_html(glyphs, stride, columns, rows, fg, bg, palette, CONSOLE_COLORS, FileSink::callback, &sink);
+        sink.flush();
+        return (fclose(file) == 0) && sink.ok;
+    }
 
-    for (size_t i = 0; i < image.image_size(); ++i)
+    BitmapFont font;
+    if (options.font.empty())
+    {
+        if (!load_atari_font(font))
+            return false;
+    }
+    else
     {
-        byte grey = (colors[i].max_value() + colors[i].min_value()) / 2;
-        Color color = colormap[static_cast<size_t>(map(grey, 0, 255, 0, map_size - 1))];
-        pixels.push_back({' ', {AUTO, color}});
+        GlyphSet glyph_set;
+        if (!load_glyph_set(options.font, options.font_size, PRINTABLE_ASCII, glyph_set))
+            return false;
+        font = bitmap_font(glyph_set);
     }
 
-    for (size_t y = 0; y < h; ++y)
-        winsole.put_line(0, y, &pixels[y * w], w);
+    std::vector<byte> pixels = rasterize_cells(glyphs, stride, columns, rows, fg, bg, palette, font);
+    return write_image(options.out, columns * font.cell_width, rows * font.cell_height, 3, pixels.data(), options.encode);
 }
 
-void print_color_ascii_fast(Winsole &winsole, const std::string &ascii_image, RGBA *&colors, const Image &image, const std::vector<Color> &colormap)
+// Splits newline separated text and its cell colors into fg/bg planes. Cell
+// colors tint the glyph, or the background in COLOR mode; the rest keep
+// default_fg/default_bg.
+bool cell_planes(const std::string &text, const std::vector<Color> &cell_colors, bool color_background, byte default_fg, byte default_bg, int &columns, int &rows, std::vector<byte> &fg, std::vector<byte> &bg)
 {
-    size_t w = image.width, h = image.height;
-    std::vector<Pixel> pixels;
-    pixels.reserve(w * h);
-
-    size_t ci = 0;
-    size_t map_size = colormap.size();
-
-    for (char ch : ascii_image)
+    size_t newline = text.find('\n');
+    columns = static_cast<int>(newline == std::string::npos ? text.size() : newline);
+    rows = static_cast<int>(text.size() + 1) / (columns + 1);
+    if (!columns || !rows)
+        return false;
+
+    fg.assign(size_t(columns) * rows, default_fg);
+    bg.assign(size_t(columns) * rows, default_bg);
+    for (size_t i = 0; i < cell_colors.size() && i < fg.size(); ++i)
     {
-        if (ch == '\n')
+        if (cell_colors[i] == AUTO)
             continue;
-        byte grey = (colors[ci].max_value() + colors[ci].min_value()) / 2;
-        Color color = colormap[static_cast<size_t>(map(grey, 0, 255, 0, map_size - 1))];
-        pixels.push_back({ch, {color, AUTO}});
-        ci++;
+        (color_background ? bg : fg)[i] = static_cast<byte>(cell_colors[i]);
     }
+    return true;
+}
 
-    for (size_t y = 0; y < h; ++y)
-        winsole.put_line(0, y, &pixels[y * w], w);
+bool write_preview(const Options &options, const std::string &text, const std::vector<Color> &cell_colors, bool color_background, const RGBA *palette)
+{
+    int columns, rows;
+    std::vector<byte> fg, bg;
+    return cell_planes(text, cell_colors, color_background, LIGHT_WHITE, BLACK, columns, rows, fg, bg) &&
+           write_cells(options, text.data(), columns + 1, columns, rows, fg.data(), bg.data(), palette);
 }
 
-void fast_print(const Winsole &console, const std::string &buffer)
+// Render cache entries are .asf frames named by the hash of the input bytes
+// and of every argument that changes the rendered cells.
+std::string render_cache_path(const std::string &input_path, const std::vector<std::string> &render_args)
 {
-    WriteConsole(console.get_handle(), buffer.c_str(), buffer.length(), nullptr, nullptr);
+    MappedFile input;
+    if (!input.open(input_path) || !input.size())
+        return "";
+    uint64_t key = xxh64(input.data(), input.size(), FRAME_VERSION);
+    for (const std::string &arg : render_args)
+        key = xxh64(arg.data(), arg.size() + 1, key); // the terminator separates arguments
+    return cache_path(RENDER_CACHE_PREFIX + hex64(key) + ".asf");
 }
 
-#define version_message "AsciiMage v1.1 (May 2025)\n\n"
-#define DEFAULT_ASCII " ._-3#@"
-#define DEFAULT_COLOR_MAP {BLACK, BLACK, GREY, GREY, BLUE, LIGHT_BLUE, AQUA, LIGHT_AQUA, WHITE, WHITE}
+void store_render(const Options &options, const std::string &path, const std::string &text, const std::vector<Color> &cell_colors, bool color_background, const RGBA *palette)
+{
+    int columns, rows;
+    std::vector<byte> fg, bg, frame;
+    if (path.empty() || !cell_planes(text, cell_colors, color_background, FRAME_DEFAULT_COLOR, FRAME_DEFAULT_COLOR, columns, rows, fg, bg))
+        return;
+    encode_frame(text.data(), columns + 1, columns, rows, fg.data(), bg.data(), palette, true, frame);
+    // One pruner for the whole run, so a --batch rescans the cache directory
+    // only when its renders could have filled it.
+    static CachePruner pruner(RENDER_CACHE_PREFIX, options.cache_limit);
+    if (write_file_atomic(path, frame.data(), frame.size()))
+        pruner.stored(frame.size());
+}
+
+// Shows a stored frame: into --out, as plain text for ASCII mode, or on the
+// console with the frame's palette when it is not the stock one. Cells left
+// in the default colors take the console's, or light white on black in --out.
+int replay_frame(ConsoleBackend &console, const Options &options, const Frame &frame, bool text_only)
+{
+    CellAttr base = options.out.empty() ? console.default_attr() : cell_attr(LIGHT_WHITE, BLACK);
+    std::vector<byte> fg, bg;
+    if (!text_only || !options.out.empty())
+    {
+        resolve_default_color(frame.fg, frame.cells(), attr_fg(base), fg);
+        resolve_default_color(frame.bg, frame.cells(), attr_bg(base), bg);
+    }
+    if (!options.out.empty())
+    {
+        bool written = write_cells(options, frame.glyphs, frame.columns, frame.columns, frame.rows, fg.data(), bg.data(), frame.palette);
+        if (!written)
+            fprintf(stderr, "[!] Failed to write %s.\n", options.out.c_str());
+        return written ? 0 : 1;
+    }
+    if (text_only)
+    {
+        std::string text;
+        text.reserve(size_t(frame.columns + 1) * frame.rows);
+        for (int row = 0; row < frame.rows; ++row)
+        {
+            if (row)
+                text += '\n';
+            text.append(frame.glyphs + size_t(row) * frame.columns, frame.columns);
+        }
+        console.write_text(text.data(), text.size());
+        return 0;
+    }
+    if (memcmp(frame.palette, default_console_palette(), sizeof(RGBA) * CONSOLE_COLORS) != 0)
+        console.set_palette(frame.palette);
+    CellGrid cells;
+    cells.assign(frame.glyphs, frame.columns, frame.columns, frame.rows, fg.data(), bg.data());
+    console.write_frame(cells.glyphs.data(), cells.attrs.data(), cells.columns, cells.rows);
+    return 0;
+}
 
 void print_help()
 {
@@ -164,6 +494,7 @@ void print_help()
     printf("[USAGE]\n");
     printf("    asciimage [--help]                Display this message.\n");
     printf("    asciimage <input> <mode> [map]    Prints an image in the selected mode.\n");
+    printf("    asciimage --batch=<list> <mode> [map]  Converts every path listed in the file, one per line.\n");
     printf("\n[MODES]\n");
     printf("    ASCII    Prints ASCII version fast.\n");
     printf("    COLOR    Colored image (optimized).\n");
@@ -171,90 +502,340 @@ void print_help()
     printf("\n[MAPS]\n");
     printf("    ASCII mode: single string map.\n");
     printf("    COLOR/ASCOL: ASCII map + color palette string (e.g., \"0193BF\").\n");
+    printf("    AUTO as color map builds a palette from the image itself.\n");
+    printf("\n[OPTIONS]\n");
+    printf("    --tone=<none|levels|equalize>    Per-image contrast curve applied before mapping.\n");
+    printf("    --background=<RRGGBB|transparent> What transparent pixels are blended with (default 000000).\n");
+    printf("    --tonemap=<auto|none|reinhard|aces> Operator for HDR and 16-bit input (auto: reinhard for HDR).\n");
+    printf("    --exposure=<float>               Exposure multiplier for HDR/16-bit input (default: auto).\n");
+    printf("    --font=<file.ttf>                Orders the ASCII map (or all printable ASCII) by measured ink.\n");
+    printf("    --font-size=<px>                 Pixel height used for --font calibration (default 16).\n");
+    printf("    --cell=<k>                       ASCII mode: one glyph per kxk block, matched by shape (needs --font).\n");
+    printf("    --match=<shape|exact>            --cell matcher: feature lookup (fast) or SSD against every glyph.\n");
+    printf("    --bench                          Times both --cell matchers on the input and reports to stderr.\n");
+    printf("    --out=<file.png>                 Renders the result through a bitmap font into an image instead.\n");
+    printf("                                     .html/.svg get colored markup, .ans escape text, .asf a\n");
+    printf("                                     replayable frame (asciimage <frame.asf> [--out=...]).\n");
+    printf("    --edges[=<threshold>]            Draws | / - \\ _ over strong edges (default threshold %d).\n", DEFAULT_EDGE_THRESHOLD);
+    printf("    --format=<png|jpg|bmp|tga>       --out/--dump encoding (default: from the --out extension).\n");
+    printf("    --quality=<1-100>                JPG quality (default 90).\n");
+    printf("    --dump=<prefix>                  Writes pipeline stages (input, lightness, quantized) as images.\n");
+    printf("    --batch=<list>                   With --out, '*' in the name is replaced by each input's name.\n");
+    printf("    --fit=<auto|none|<cols>x<rows>>  Shrinks the image to at most that many cells (auto: the terminal's\n");
+    printf("                                     width, when printing to one).\n");
+    printf("    --cache[=<MB>]                   Reuses renders of the same input and arguments from disk (default %d MB).\n", DEFAULT_CACHE_MB);
+    printf("    --png-level=<0-9>                --out compression effort, 0 stores (default 6).\n");
+    printf("    --png-filter=<none|sub|up|avg|paeth|adaptive> --out row filter (default adaptive).\n");
+    printf("    --png-strips[=<n>]               Deflates --out in n parallel slices (default: one per core).\n");
 }
 
-int main(int argc, char *argv[])
+// Per-input working memory, kept from one input to the next. The buffers
+// only ever grow, and the arena takes stb_image's allocations (the decoded
+// pixels included) and is reset after each input, so a batch of similar
+// images stops allocating after the first one.
+struct Scratch
 {
-    argc -= 1;
-    if (!argc)
-    {
-        print_help();
-        return 0;
-    }
+    PixelPlanes planes, fitted;
+    std::vector<byte> lightness, opaque, indices;
+    std::vector<Color> cell_colors;
+    CellGrid cells;
+    std::string text;
+    ScratchArena arena;
+};
+
+// Runs the whole pipeline for one input. str_args holds the input, the mode
+// and the maps.
+int convert(ConsoleBackend &console, const Options &options, const std::vector<std::string> &str_args, const std::vector<std::string> &option_args, Scratch &scratch)
+{
+    int argc = static_cast<int>(str_args.size());
+    const std::string &input_path = str_args[0];
+    std::string ascii_map, color_map;
 
-    std::string str_args[argc];
-    for (size_t i = 0; i < argc; i++)
+    std::string input_extension = input_path.substr(input_path.find_last_of('.') + 1);
+    if (input_extension == "asf" || input_extension == "ASF")
     {
-        str_args[i] = argv[i + 1];
-        if (str_args[i] == "-h" || str_args[i] == "--help")
+        MappedFile file;
+        Frame frame;
+        if (!file.open(input_path) || !frame.parse(file.data(), file.size()))
         {
-            print_help();
-            return 0;
+            fprintf(stderr, "[!] Failed to read frame.\n");
+            return 1;
         }
+        return replay_frame(console, options, frame, false);
     }
 
-    Winsole console;
-    if (!console.init())
+    int max_columns, max_rows;
+    fit_limits(console, options, max_columns, max_rows);
+
+    std::string cache_file;
+    if (options.cache_limit)
     {
-        fprintf(stderr, "[!] Failed to init console.\n");
-        return 1;
+        std::vector<std::string> render_args(str_args.begin() + 1, str_args.end());
+        render_args.insert(render_args.end(), option_args.begin(), option_args.end());
+        // --fit as resolved for this run, so a resized terminal misses.
+        render_args.push_back("--fit=" + std::to_string(max_columns) + "x" + std::to_string(max_rows));
+        cache_file = render_cache_path(input_path, render_args);
+
+        MappedFile cached;
+        Frame frame;
+        if (!cache_file.empty() && cached.open(cache_file) && frame.parse(cached.data(), cached.size()))
+        {
+            touch_file(cache_file);
+            return replay_frame(console, options, frame, str_args[1] == "ASCII");
+        }
     }
 
-    std::string input_path = str_args[0];
-    std::string ascii_map, color_map;
-
-    Image input_image(input_path.c_str());
-    if (!input_image.read())
+    bool has_alpha = file_has_alpha(input_path);
+    Image input_image(input_path, has_alpha ? 4 : 3);
+    bool loaded = is_high_precision(input_path) ? read_high_precision(input_image, options.hdr) : input_image.read();
+    if (!loaded)
     {
         fprintf(stderr, "[!] Failed to read image.\n");
         return 1;
     }
 
-    RGBA *colors = nullptr;
-    input_image.get_color_array(colors);
-    if (!colors)
+    PixelPlanes &planes = scratch.planes;
+    // With alpha, L is derived while compositing instead.
+    planes.deinterleave(input_image.data, input_image.width, input_image.height, input_image.channels, !has_alpha);
+    int columns, rows;
+    if (fit_grid(planes.width, planes.height, max_columns, max_rows, columns, rows))
     {
-        fprintf(stderr, "[!] Failed to get color array.\n");
-        return 1;
+        scratch.fitted.downsample(planes, columns, rows, !has_alpha);
+        std::swap(scratch.planes, scratch.fitted);
     }
 
-    if (argc == 1)
-        str_args[1] = "ASCII";
+    std::vector<byte> &opaque = scratch.opaque;
+    std::vector<byte> &lightness = scratch.lightness;
+    opaque.clear();
+    if (has_alpha)
+        composite_lightness_plane(planes, options.background, opaque, lightness);
+    else
+        lightness_plane(planes, lightness);
+    // Transparent cells are never drawn and their colors are undefined, so
+    // they take no part in fitting the tone curve or an AUTO palette.
+    const byte *visible = opaque.empty() ? nullptr : opaque.data();
+    ToneCurve curve = tone_curve(options.tone, lightness.data(), lightness.size(), visible);
+
+    StageWriter stages;
+    stages.prefix = options.dump;
+    stages.options = options.encode;
+    if (stages.enabled())
+    {
+        std::vector<byte> toned(lightness.size());
+        for (size_t i = 0; i < lightness.size(); ++i)
+            toned[i] = curve[lightness[i]];
+        bool dumped = stages.write("input", input_image.width, input_image.height, input_image.channels, input_image.data);
+        if (!dumped || !stages.write("lightness", planes.width, planes.height, 1, toned.data()))
+            fprintf(stderr, "[!] Failed to write stages to %s.\n", options.dump.c_str());
+    }
 
     if (str_args[1] == "ASCII")
     {
         ascii_map = (argc == 2) ? DEFAULT_ASCII : str_args[2];
-        std::string ascii_output = ascii_image(input_image, colors, ascii_map);
-        fast_print(console, ascii_output);
-        delete[] colors;
+        std::string &ascii_output = scratch.text;
+        if (options.cell)
+        {
+            GlyphSet glyph_set;
+            if (options.font.empty() || !load_glyph_set(options.font, options.font_size, argc > 2 ? ascii_map : PRINTABLE_ASCII, glyph_set))
+            {
+                fprintf(stderr, "[!] --cell needs a readable --font.\n");
+                return 1;
+            }
+            if (options.bench)
+                bench_matchers(lightness, planes.width, planes.height, options.cell, glyph_set, curve);
+
+            if (options.exact)
+            {
+                ascii_output = exact_ascii_image(lightness.data(), planes.width, planes.height, options.cell, build_atlas(glyph_set), curve);
+            }
+            else
+            {
+                ShapeMatcher matcher(glyph_set);
+                ascii_output = shape_ascii_image(lightness.data(), planes.width, planes.height, options.cell, matcher, curve);
+            }
+        }
+        else if (options.edges)
+        {
+            ascii_output = edge_ascii_image(lightness.data(), planes.width, planes.height, glyph_lut(options, ascii_map, argc > 2, curve), opaque, options.edges);
+        }
+        else
+        {
+            density_ascii_image(lightness.data(), opaque.empty() ? nullptr : opaque.data(), planes.width, planes.height, glyph_lut(options, ascii_map, argc > 2, curve), ascii_output);
+        }
+        store_render(options, cache_file, ascii_output, {}, false, default_console_palette());
+        if (!options.out.empty())
+        {
+            bool written = write_preview(options, ascii_output, {}, false, default_console_palette());
+            if (!written)
+                fprintf(stderr, "[!] Failed to write %s.\n", options.out.c_str());
+            return written ? 0 : 1;
+        }
+        console.write_text(ascii_output.data(), ascii_output.size());
         return 0;
     }
 
-    std::vector<Color> colormap;
-    if (argc == 2)
+    std::vector<Color> &cell_colors = scratch.cell_colors;
+    RGBA preview_palette[CONSOLE_COLORS];
+    std::copy(default_console_palette(), default_console_palette() + CONSOLE_COLORS, preview_palette);
+    if (argc > 2 && str_args[2] == AUTO_COLOR_MAP)
     {
-        colormap = DEFAULT_COLOR_MAP;
+        Palette palette = adaptive_palette(planes, CONSOLE_COLORS, visible);
+        PaletteLUT lut;
+        lut.build(palette);
+        palette_colors(planes, lut, opaque, scratch.indices, cell_colors);
+        std::copy(palette.entries.begin(), palette.entries.end(), preview_palette);
+        if (options.out.empty())
+            console.set_palette(preview_palette);
     }
     else
     {
-        for (char ch : str_args[2])
+        std::vector<Color> colormap;
+        if (argc == 2)
+        {
+            colormap = DEFAULT_COLOR_MAP;
+        }
+        else
         {
-            Color color = (ch >= 'A' && ch <= 'F') ? static_cast<Color>((ch - 'A') + 10) : static_cast<Color>(ch - '0');
-            colormap.push_back(color);
+            for (char ch : str_args[2])
+            {
+                Color color = (ch >= 'A' && ch <= 'F') ? static_cast<Color>((ch - 'A') + 10) : static_cast<Color>(ch - '0');
+                colormap.push_back(color);
+            }
         }
+        lightness_colors(lightness, ramp_lut<Color>(colormap, colormap.size(), curve), opaque, cell_colors);
     }
+    if (!dump_cell_colors(stages, planes.width, planes.height, cell_colors, preview_palette))
+        fprintf(stderr, "[!] Failed to write stages to %s.\n", options.dump.c_str());
 
+    bool written = true;
     if (str_args[1] == "COLOR")
     {
-        print_color_image_fast(console, input_image, colors, colormap);
+        std::string blank;
+        if (!options.out.empty() || !cache_file.empty())
+        {
+            blank.assign(size_t(planes.width + 1) * planes.height - 1, ' ');
+            for (size_t row = 1; row < size_t(planes.height); ++row)
+                blank[row * (planes.width + 1) - 1] = '\n';
+            store_render(options, cache_file, blank, cell_colors, true, preview_palette);
+        }
+        if (options.out.empty())
+        {
+            fill_cells(nullptr, planes.width, planes.height, cell_colors, true, console.default_attr(), scratch.cells);
+            console.write_frame(scratch.cells.glyphs.data(), scratch.cells.attrs.data(), scratch.cells.columns, scratch.cells.rows);
+        }
+        else
+        {
+            written = write_preview(options, blank, cell_colors, true, preview_palette);
+        }
     }
     else if (str_args[1] == "ASCOL")
     {
         std::string ascii_map = (argc == 4) ? str_args[3] : DEFAULT_ASCII;
-        std::string ascii_output = ascii_image(input_image, colors, ascii_map);
-        print_color_ascii_fast(console, ascii_output, colors, input_image, colormap);
+        std::array<char, 256> glyphs = glyph_lut(options, ascii_map, argc == 4, curve);
+        std::string &ascii_output = scratch.text;
+        if (options.edges)
+            ascii_output = edge_ascii_image(lightness.data(), planes.width, planes.height, glyphs, opaque, options.edges);
+        else
+            density_ascii_image(lightness.data(), opaque.empty() ? nullptr : opaque.data(), planes.width, planes.height, glyphs, ascii_output);
+        store_render(options, cache_file, ascii_output, cell_colors, false, preview_palette);
+        if (options.out.empty())
+        {
+            fill_cells(ascii_output.data(), planes.width, planes.height, cell_colors, false, console.default_attr(), scratch.cells);
+            console.write_frame(scratch.cells.glyphs.data(), scratch.cells.attrs.data(), scratch.cells.columns, scratch.cells.rows);
+        }
+        else
+        {
+            written = write_preview(options, ascii_output, cell_colors, false, preview_palette);
+        }
     }
 
-    delete[] colors;
+    if (!written)
+    {
+        fprintf(stderr, "[!] Failed to write %s.\n", options.out.c_str());
+        return 1;
+    }
     return 0;
 }
+
+int main(int argc, char *argv[])
+{
+    argc -= 1;
+    if (!argc)
+    {
+        print_help();
+        return 0;
+    }
+
+    std::vector<std::string> str_args, option_args;
+    Options options;
+    for (int i = 1; i <= argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help")
+        {
+            print_help();
+            return 0;
+        }
+        if (arg.compare(0, 2, "--") == 0)
+        {
+            if (!parse_option(arg, options))
+            {
+                fprintf(stderr, "[!] Invalid option %s.\n", arg.c_str());
+                return 1;
+            }
+            if (changes_render(arg))
+                option_args.push_back(arg);
+            continue;
+        }
+        str_args.push_back(arg);
+    }
+
+    if (!options.batch.empty())
+        str_args.insert(str_args.begin(), std::string()); // filled per input
+    argc = static_cast<int>(str_args.size());
+    if (!argc)
+    {
+        print_help();
+        return 0;
+    }
+
+    PlatformConsole console;
+    if (!console.init())
+    {
+        fprintf(stderr, "[!] Failed to init console.\n");
+        return 1;
+    }
+
+    if (argc == 1)
+        str_args.push_back("ASCII");
+
+    Scratch scratch;
+    if (options.batch.empty())
+        return convert(console, options, str_args, option_args, scratch);
+
+    // Every input decodes into the scratch arena, which is emptied after each
+    // one; the first image sizes it for the rest of the batch.
+    FILE *list = fopen(options.batch.c_str(), "r");
+    if (!list)
+    {
+        fprintf(stderr, "[!] Failed to read %s.\n", options.batch.c_str());
+        return 1;
+    }
+    UseImageAllocator use_arena(&scratch.arena);
+    Options item_options = options;
+    int failed = 0;
+    char line[4096];
+    while (fgets(line, sizeof(line), list))
+    {
+        std::string path = line;
+        path.erase(path.find_last_not_of("\r\n") + 1);
+        if (path.empty())
+            continue;
+        str_args[0] = path;
+        item_options.out = batch_output(options.out, path);
+        failed += convert(console, item_options, str_args, option_args, scratch) != 0;
+        scratch.arena.reset();
+    }
+    fclose(list);
+    return failed ? 1 : 0;
+}
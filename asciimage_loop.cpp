@@ -2,84 +2,25 @@
 #include <stdint.h>
 #include <string>
 #include <vector>
-#include <conio.h>
-#include "winsole/winsole.hpp"
+#include "winsole/colors.hpp"
+#include "core/image.hpp"
+#include "core/cells.hpp"
+#include "platform/console.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
 
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb/stb_image_write.h"
-
-typedef unsigned char byte;
-
-struct RGBA {
-    byte r, g, b, a = 255;
-
-    byte max_value() const { return (r > g ? (r > b ? r : b) : (g > b ? g : b)); }
-    byte min_value() const { return (r < g ? (r < b ? r : b) : (g < b ? g : b)); }
-    float average() const { return (r + g + b) / 3.0f; }
-};
-
-struct Image {
-    std::string path;
-    int width, height, bpp, channels;
-    byte* data = nullptr;
-
-    Image() = default;
-
-    Image(std::string path, int channels = 3) : path(path), channels(channels) {
-        if (channels < 3 || channels > 4) {
-            fprintf(stderr, "[!] Invalid number of channels for Image.\n");
-            exit(1);
-        }
+std::vector<RGBA> get_color_array(const Image& image) {
+    std::vector<RGBA> color_array(image.image_size());
+    for (size_t b = 0, color = 0; b < image.size(); b += image.channels) {
+        color_array[color++] = {image.data[b], image.data[b + 1], image.data[b + 2], (image.channels == 4) ? image.data[b + 3] : static_cast<byte>(255)};
     }
-
-    size_t size() const { return width * height * channels; }
-    size_t image_size() const { return width * height; }
-
-    bool read(std::string rpath = "", int rchannels = 0) {
-        if(rchannels < 3 || rchannels > 4) rchannels = channels;
-        if(rpath.empty()) rpath = path;
-        if(data) stbi_image_free(data);
-
-        data = stbi_load(rpath.c_str(), &width, &height, &bpp, rchannels);
-        if (!data) return false;
-
-        channels = rchannels;
-        return true;
-    }
-
-    void write(std::string rpath = nullptr, int rchannels = 0) const {
-        if(rchannels < 3 || rchannels > 4) rchannels = channels;
-        if(rpath.empty()) rpath = path;
-
-        if(rchannels == 3) {
-            stbi_write_jpg(rpath.c_str(), width, height, channels, data, 100);
-        } else {
-            stbi_write_png(rpath.c_str(), width, height, channels, data, 0);
-        }
-    }
-
-    void get_color_array(RGBA*& color_array) const {
-        if (color_array) delete[] color_array;
-        color_array = new RGBA[image_size()];
-        for (size_t b = 0, color = 0; b < size(); b += channels) {
-            color_array[color++] = {data[b], data[b + 1], data[b + 2], (channels == 4) ? data[b + 3] : static_cast<byte>(255)};
-        }
-    }
-
-    ~Image() {
-        if (data) stbi_image_free(data);
-    }
-};
-
-float map(float input, float x1, float x2, float y1, float y2) {
-    return y1 + (input - x1) * (y2 - y1) / (x2 - x1);
+    return color_array;
 }
 
-std::string ascii_image(const Image& image, RGBA*& colors, const std::string& ascii_map) {
+std::string ascii_image(const Image& image, const std::vector<RGBA>& colors, const std::string& ascii_map) {
     std::string ascii_output;
+    ascii_output.reserve(image.image_size() + image.height); // '\n's
     for(size_t ci = 0, row = 1; ci < image.image_size(); ci++) {
         byte grey = (colors[ci].max_value() + colors[ci].min_value()) / 2;
         byte index = map(grey, 0, 255, 0, ascii_map.length() - 1);
@@ -92,44 +33,34 @@ std::string ascii_image(const Image& image, RGBA*& colors, const std::string& as
     return ascii_output;
 }
 
-void print_color_image(Winsole& winsole, const Image& image, RGBA*& colors, const std::vector<Color>& colormap) {
-    size_t map_size = colormap.size();
-    for(size_t ci = 0, row = 1; ci < image.image_size(); ci++) {
-        byte grey = (colors[ci].max_value() + colors[ci].min_value()) / 2;
-        size_t index = static_cast<size_t>(map(grey, 0, 255, 0, map_size - 1));
-        Color color = colormap[index];
-
-        if(ci >= (row * image.width)) {
-            putchar('\n');
-            row++;
-        }
+byte map_color(const RGBA& color, const std::vector<Color>& colormap) {
+    byte grey = (color.max_value() + color.min_value()) / 2;
+    return colormap[static_cast<size_t>(map(grey, 0, 255, 0, colormap.size() - 1))];
+}
 
-        winsole.put(' ', {AUTO, color});
+// Every mode fills a grid of glyphs and packed attributes (fg | bg << 4);
+// cells without a mapped color keep the console's colors from `base`.
+void ascii_cells(const std::string& ascii_image, const Image& image, CellAttr base, CellGrid& cells) {
+    cells.resize(image.width, image.height);
+    for(size_t ai = 0, ci = 0; ai < ascii_image.size(); ai++) {
+        if(ascii_image[ai] == '\n') continue;
+        cells.glyphs[ci] = ascii_image[ai];
+        cells.attrs[ci++] = base;
     }
 }
 
-void print_color_ascii(Winsole& winsole, const std::string& ascii_image, RGBA*& colors, const Image& image, const std::vector<Color>& colormap) {
-    size_t map_size = colormap.size();
-    size_t ascii_index = 0;
-
+void color_image_cells(const Image& image, const std::vector<RGBA>& colors, const std::vector<Color>& colormap, CellAttr base, CellGrid& cells) {
+    cells.resize(image.width, image.height);
     for(size_t ci = 0; ci < image.image_size(); ci++) {
-        if(ascii_image[ascii_index] == '\n') {
-            putchar('\n');
-            ascii_index += 2;
-            continue;
-        }
-
-        byte grey = (colors[ci].max_value() + colors[ci].min_value()) / 2;
-        size_t index = static_cast<size_t>(map(grey, 0, 255, 0, map_size - 1));
-        Color color = colormap[index];
-
-        winsole.put(ascii_image[ascii_index], {color, AUTO});
-        ascii_index++;
+        cells.glyphs[ci] = ' ';
+        cells.attrs[ci] = cell_attr(attr_fg(base), map_color(colors[ci], colormap));
     }
 }
 
-void fast_print(const Winsole& console, const std::string& buffer) {
-    WriteConsole(console.get_handle(), buffer.c_str(), buffer.length(), nullptr, nullptr);
+void color_ascii_cells(const std::string& ascii_image, const std::vector<RGBA>& colors, const Image& image, const std::vector<Color>& colormap, CellAttr base, CellGrid& cells) {
+    ascii_cells(ascii_image, image, base, cells);
+    for(size_t ci = 0; ci < image.image_size(); ci++)
+        cells.attrs[ci] = cell_attr(map_color(colors[ci], colormap), attr_bg(base));
 }
 
 #define version_message "AsciiMage v1.0 (Dec 9 2024)\n\n"
@@ -160,8 +91,6 @@ void print_help() {
 #define DEFAULT_ASCII " ._-3#@"
 #define DEFAULT_COLOR_MAP {BLACK, BLACK, BLACK, GREY, GREY, BLUE, LIGHT_BLUE, AQUA, LIGHT_AQUA, WHITE, WHITE, WHITE}
 
-#define LOOP while(true) if(kbhit()) break
-
 int main(int argc, char* argv[]) {
     argc -= 1;
 
@@ -171,62 +100,51 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
+    // BASIC CONSOLE SETUP
+    PlatformConsole console;
+    if(!console.init()) {
+        fprintf(stderr, "[!] Failed to init the console.\n");
+        return 1;
+    }
+
     // Stringify argv to compare easily
-    std::string str_args[argc];
-    for(size_t i = 0; i < argc; i++) {
+    std::vector<std::string> str_args(argc < 2 ? 2 : argc);
+    for(int i = 0; i < argc; i++) {
         str_args[i] = argv[i + 1];
 
         // HELP
         if(str_args[i] == "-h" || str_args[i] == "--help") {
             print_help();
-            LOOP;
+            wait_key(console);
             return 0;
         }
     }
 
-    // BASIC CONSOLE SETUP
-    Winsole console;
-    if(!console.init()) {
-        fprintf(stderr, "[!] Failed to init the console.\n");
-        LOOP;
-        return 1;
-    }
-
-    // console.set_raw_size({300, 9000});
-    // if(console.update()) {
-    //     fprintf(stderr, "[!] Failed to resize the console buffer.\n");
-    //     return 1;
-    // }
-
     std::string input_path = str_args[0];
     std::string ascii_map, color_map;
 
-    Image input_image(input_path.c_str());
+    Image input_image(input_path);
     if(!input_image.read()) {
         fprintf(stderr, "[!] Failed to read image.\n");
-        LOOP;
+        wait_key(console);
         return 1;
     }
 
-    RGBA* colors = nullptr;
-    input_image.get_color_array(colors);
-    if(!colors) {
+    std::vector<RGBA> colors = get_color_array(input_image);
+    if(colors.empty()) {
         fprintf(stderr, "[!] Failed to get color array.\n");
-        LOOP;
+        wait_key(console);
         return 1;
     }
 
     if(argc == 1) str_args[1] = "ASCII";
 
+    CellGrid cells;
+    CellAttr base = console.default_attr();
     if(str_args[1] == "ASCII") {
         ascii_map = (argc == 2) ? DEFAULT_ASCII : str_args[2];
-        std::string ascii_output = ascii_image(input_image, colors, ascii_map);
-        fast_print(console, ascii_output);
-        LOOP;
-        return 0;
-    }
-    
-    if(str_args[1] == "COLOR" || str_args[1] == "ASCOL") {
+        ascii_cells(ascii_image(input_image, colors, ascii_map), input_image, base, cells);
+    } else if(str_args[1] == "COLOR" || str_args[1] == "ASCOL") {
         std::vector<Color> colormap;
         if(argc == 2) {
             colormap = DEFAULT_COLOR_MAP;
@@ -238,18 +156,21 @@ int main(int argc, char* argv[]) {
         }
 
         if(str_args[1] == "COLOR") {
-            print_color_image(console, input_image, colors, colormap);
-        } else if (str_args[1] == "ASCOL") {
+            color_image_cells(input_image, colors, colormap, base, cells);
+        } else {
             std::string ascii_map = (argc == 4) ? str_args[3] : DEFAULT_ASCII;
-            std::string ascii_output = ascii_image(input_image, colors, ascii_map);
-            print_color_ascii(console, ascii_output, colors, input_image, colormap);
+            color_ascii_cells(ascii_image(input_image, colors, ascii_map), colors, input_image, colormap, base, cells);
         }
-
-        LOOP;
+    } else {
+        wait_key(console);
         return 0;
     }
 
-    delete[] colors;
-    LOOP;
+    // Drawn off screen and shown in one go; the original screen comes back
+    // on exit.
+    console.enter_screen();
+    console.write_frame(cells.glyphs.data(), cells.attrs.data(), cells.columns, cells.rows);
+    wait_key(console, &cells);
+    console.leave_screen();
     return 0;
 }
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Where stb_image gets its memory (see STBI_MALLOC in asciimage.cpp). Every
+// block carries a small header naming the allocator that served it, so a
+// buffer is always returned to its owner, whichever allocator is current
+// when it is freed.
+class ImageAllocator {
+public:
+    virtual ~ImageAllocator() = default;
+    virtual void* allocate(size_t size) = 0;
+    virtual void release(void* block, size_t size) = 0;
+    // Grows or shrinks a block where it is; false means the caller must move it.
+    virtual bool resize(void*, size_t, size_t) { return false; }
+};
+
+// The allocator used by this thread's decodes; nullptr means malloc/free.
+inline ImageAllocator*& current_image_allocator() {
+    thread_local ImageAllocator* allocator = nullptr;
+    return allocator;
+}
+
+// Installs an allocator for the lifetime of the scope.
+class UseImageAllocator {
+public:
+    explicit UseImageAllocator(ImageAllocator* allocator) : previous(current_image_allocator()) {
+        current_image_allocator() = allocator;
+    }
+    ~UseImageAllocator() { current_image_allocator() = previous; }
+    UseImageAllocator(const UseImageAllocator&) = delete;
+    UseImageAllocator& operator=(const UseImageAllocator&) = delete;
+
+private:
+    ImageAllocator* previous;
+};
+
+struct alignas(16) ImageBlockHeader {
+    ImageAllocator* owner;
+    size_t size;
+};
+
+inline void* image_malloc(size_t size) {
+    ImageAllocator* owner = current_image_allocator();
+    size_t total = sizeof(ImageBlockHeader) + size;
+    void* block = owner ? owner->allocate(total) : malloc(total);
+    if(!block) return nullptr;
+    ImageBlockHeader* header = static_cast<ImageBlockHeader*>(block);
+    header->owner = owner;
+    header->size = size;
+    return header + 1;
+}
+
+inline void image_free(void* p) {
+    if(!p) return;
+    ImageBlockHeader* header = static_cast<ImageBlockHeader*>(p) - 1;
+    if(header->owner) header->owner->release(header, sizeof(ImageBlockHeader) + header->size);
+    else free(header);
+}
+
+inline void* image_realloc(void* p, size_t size) {
+    if(!p) return image_malloc(size);
+    ImageBlockHeader* header = static_cast<ImageBlockHeader*>(p) - 1;
+    if(!header->owner) {
+        header = static_cast<ImageBlockHeader*>(realloc(header, sizeof(ImageBlockHeader) + size));
+        if(!header) return nullptr;
+        header->size = size;
+        return header + 1;
+    }
+    if(header->owner->resize(header, sizeof(ImageBlockHeader) + header->size, sizeof(ImageBlockHeader) + size)) {
+        header->size = size;
+        return p;
+    }
+    void* grown = image_malloc(size);
+    if(grown) {
+        memcpy(grown, p, header->size < size ? header->size : size);
+        image_free(p);
+    }
+    return grown;
+}
+
+// Bump allocator for everything one input needs while it is converted.
+// Allocation is a pointer increment, and only the most recent block is given
+// back or grown in place (the realloc pattern of stb's decoders, which keep
+// growing the buffer they just made); reset() drops all of it at once. A
+// request that does not fit is served by malloc and remembered; the next
+// reset() folds those into one chunk big enough for the whole image, so a
+// batch of similar images settles into a single chunk and never calls malloc
+// again. Not thread-safe: use one arena per worker.
+class ScratchArena : public ImageAllocator {
+public:
+    explicit ScratchArena(size_t initial = 0) { if(initial) grow(initial); }
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    ~ScratchArena() override {
+        drop_overflow();
+        free(chunk);
+    }
+
+    void* allocate(size_t size) override {
+        size = round_up(size);
+        if(size <= capacity - used) {
+            void* block = chunk + used;
+            used += size;
+            if(used > high_water) high_water = used;
+            return block;
+        }
+        void* block = malloc(size);
+        if(block) {
+            overflow.push_back(block);
+            overflow_bytes += size;
+        }
+        return block;
+    }
+
+    void release(void* block, size_t size) override {
+        size = round_up(size);
+        if(static_cast<unsigned char*>(block) + size == chunk + used) used -= size;
+    }
+
+    bool resize(void* block, size_t size, size_t new_size) override {
+        size = round_up(size);
+        new_size = round_up(new_size);
+        unsigned char* start = static_cast<unsigned char*>(block);
+        if(start + size != chunk + used) return new_size <= size;
+        if(new_size > capacity - (start - chunk)) return false;
+        used = (start - chunk) + new_size;
+        if(used > high_water) high_water = used;
+        return true;
+    }
+
+    // Everything handed out since the last reset() becomes invalid.
+    void reset() {
+        if(!overflow.empty()) {
+            size_t needed = high_water + overflow_bytes;
+            drop_overflow();
+            grow(needed);
+        }
+        used = 0;
+        high_water = 0;
+    }
+
+    size_t size() const { return capacity; }
+
+private:
+    static constexpr size_t ALIGN = 16;
+    unsigned char* chunk = nullptr;
+    size_t capacity = 0, used = 0, high_water = 0;
+    std::vector<void*> overflow;
+    size_t overflow_bytes = 0;
+
+    static size_t round_up(size_t size) { return (size + ALIGN - 1) & ~(ALIGN - 1); }
+
+    void grow(size_t size) {
+        free(chunk);
+        capacity = round_up(size);
+        chunk = static_cast<unsigned char*>(malloc(capacity));
+        if(!chunk) capacity = 0;
+    }
+
+    void drop_overflow() {
+        for(void* block : overflow) free(block);
+        overflow.clear();
+        overflow_bytes = 0;
+    }
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "image.hpp"
+#include "tone.hpp"
+
+// What transparent pixels are composited against. A transparent background
+// leaves those cells untouched instead (space / AUTO color).
+struct Background {
+    bool transparent = false;
+    RGBA color = {0, 0, 0, 255};
+};
+
+inline bool parse_background(const std::string& value, Background& background) {
+    if(value == "transparent") {
+        background.transparent = true;
+        return true;
+    }
+    if(value.size() != 6 || value.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+        return false;
+    unsigned long rgb = std::strtoul(value.c_str(), nullptr, 16);
+    background.transparent = false;
+    background.color = {static_cast<byte>(rgb >> 16), static_cast<byte>(rgb >> 8), static_cast<byte>(rgb)};
+    return true;
+}
+
+// stbi_info only parses the header; gray+alpha (2) and RGBA (4) carry alpha.
+inline bool file_has_alpha(const std::string& path) {
+    int width, height, comp;
+    return stbi_info(path.c_str(), &width, &height, &comp) && (comp == 2 || comp == 4);
+}
+
+// Rounded x / 255 for x in [0, 255 * 255], without a division.
+inline uint32_t div255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+// p = round((p * a + back * (255 - a)) / 255), 16 pixels a step in 16-bit
+// lanes, where the sum still fits. Rows must be 16-byte aligned.
+inline void composite_row(byte* p, const byte* a, byte back, int width) {
+    int x = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i zero = _mm_setzero_si128(), full = _mm_set1_epi16(255);
+    const __m128i background = _mm_set1_epi16(back), round = _mm_set1_epi16(128);
+    auto blend = [&](__m128i vp, __m128i va) {
+        __m128i sum = _mm_add_epi16(_mm_mullo_epi16(vp, va), _mm_mullo_epi16(background, _mm_sub_epi16(full, va)));
+        sum = _mm_add_epi16(sum, round);
+        return _mm_srli_epi16(_mm_add_epi16(sum, _mm_srli_epi16(sum, 8)), 8);
+    };
+    for(; x + 16 <= width; x += 16) {
+        __m128i vp = _mm_load_si128(reinterpret_cast<const __m128i*>(p + x));
+        __m128i va = _mm_load_si128(reinterpret_cast<const __m128i*>(a + x));
+        __m128i lo = blend(_mm_unpacklo_epi8(vp, zero), _mm_unpacklo_epi8(va, zero));
+        __m128i hi = blend(_mm_unpackhi_epi8(vp, zero), _mm_unpackhi_epi8(va, zero));
+        _mm_store_si128(reinterpret_cast<__m128i*>(p + x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for(; x < width; x++)
+        p[x] = static_cast<byte>(div255(p[x] * uint32_t(a[x]) + uint32_t(back) * (255 - a[x])));
+}
+
+// Composites straight-alpha planes over the background in place and derives
+// L, both in one pass per row while it is still in cache; the planes need no
+// L beforehand (see PixelPlanes::deinterleave). With a transparent
+// background the colors are left alone and `opaque` marks which cells should
+// be drawn. The compact L plane goes to `lightness`.
+inline void composite_lightness_plane(PixelPlanes& planes, const Background& background, std::vector<byte>& opaque, std::vector<byte>& lightness) {
+    opaque.clear();
+    if(background.transparent) opaque.resize(planes.pixel_count());
+    lightness.resize(planes.pixel_count());
+    const byte background_channels[3] = {background.color.r, background.color.g, background.color.b};
+    for(int y = 0; y < planes.height; y++) {
+        byte* a = planes.row(CHANNEL_A, y);
+        if(background.transparent) {
+            byte* out = opaque.data() + size_t(y) * planes.width;
+            for(int x = 0; x < planes.width; x++) out[x] = a[x] >= 128;
+        } else {
+            for(int c = CHANNEL_R; c <= CHANNEL_B; c++)
+                composite_row(planes.row(static_cast<Channel>(c), y), a, background_channels[c], planes.width);
+            memset(a, 255, planes.width);
+        }
+        byte* l = planes.row(CHANNEL_L, y);
+        lightness_row(planes.row(CHANNEL_R, y), planes.row(CHANNEL_G, y), planes.row(CHANNEL_B, y), l, planes.width);
+        memcpy(lightness.data() + size_t(y) * planes.width, l, planes.width);
+    }
+}
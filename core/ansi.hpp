@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include "image.hpp"
+#include "markup.hpp"
+#include "cells.hpp"
+
+// Console color index (Windows order: bit 0 blue, bit 1 green, bit 2 red,
+// bit 3 bright) to the SGR foreground code; add 10 for the background.
+inline int ansi_color_code(byte index) {
+    int base = ((index & 1) << 2) | (index & 2) | ((index & 4) >> 2);
+    return (index & 8 ? 90 : 30) + base;
+}
+
+// SGR color encodings, cheapest first. BASIC names one of the terminal's own
+// 16 colors (ESC[97;44m), XTERM256 an entry of the xterm 256-color table
+// (ESC[38;5;231;48;5;17m), TRUECOLOR sends RGB (up to SGR_MAX bytes); NONE
+// sends no color at all.
+enum class ColorSupport {
+    NONE, BASIC, XTERM256, TRUECOLOR
+};
+
+// Nearest entry of the xterm 256-color table: its 6x6x6 cube or its 24-step
+// grey ramp (the first 16 entries are the terminal's own colors).
+inline byte xterm256_index(const RGBA& c) {
+    auto level = [](int v) { return v < 48 ? 0 : v < 115 ? 1 : (v - 35) / 40; };
+    auto value = [](int l) { return l ? 55 + l * 40 : 0; };
+    auto distance = [&](int r, int g, int b) { return (c.r - r) * (c.r - r) + (c.g - g) * (c.g - g) + (c.b - b) * (c.b - b); };
+    int r = level(c.r), g = level(c.g), b = level(c.b);
+    int step = std::min(23, std::max(0, ((c.r + c.g + c.b) / 3 - 3) / 10));
+    int grey = 8 + step * 10;
+    if(distance(grey, grey, grey) < distance(value(r), value(g), value(b))) return static_cast<byte>(232 + step);
+    return static_cast<byte>(16 + 36 * r + 6 * g + b);
+}
+
+inline RGBA xterm256_color(byte index) {
+    if(index >= 232) {
+        byte grey = static_cast<byte>(8 + (index - 232) * 10);
+        return {grey, grey, grey};
+    }
+    auto value = [](int l) { return static_cast<byte>(l ? 55 + l * 40 : 0); };
+    int cube = index - 16;
+    return {value(cube / 36), value(cube / 6 % 6), value(cube % 6)};
+}
+
+// Whether every palette entry is on the xterm table, so XTERM256 shows the
+// palette as well as TRUECOLOR does.
+inline bool xterm256_exact(const RGBA* palette) {
+    for(int i = 0; i < 16; i++) {
+        RGBA shown = xterm256_color(xterm256_index(palette[i]));
+        if(shown.r != palette[i].r || shown.g != palette[i].g || shown.b != palette[i].b) return false;
+    }
+    return true;
+}
+
+// The cheapest encoding up to `limit` that shows `palette` as it is, else
+// the richest one `limit` allows. The stock palette is the terminal's own 16
+// colors, so it never needs more than BASIC.
+inline ColorSupport cheapest_colors(const RGBA* palette, bool stock, ColorSupport limit) {
+    if(stock || limit <= ColorSupport::BASIC) return std::min(limit, ColorSupport::BASIC);
+    if(limit == ColorSupport::XTERM256 || xterm256_exact(palette)) return ColorSupport::XTERM256;
+    return ColorSupport::TRUECOLOR;
+}
+
+// Longest sequence write_sgr emits: ESC[38;2;255;255;255;48;2;255;255;255m.
+constexpr size_t SGR_MAX = 36;
+#define SGR_ROW_END "\x1b[0m\n"
+
+inline char* write_decimal(char* out, unsigned value) {
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while(value);
+    while(count) *out++ = digits[--count];
+    return out;
+}
+
+// Writes the color sequence for one fg/bg pair at `out`, at most SGR_MAX
+// bytes, and returns the end. A CELL_DEFAULT_COLOR channel gets the
+// terminal's own color back (39/49). NONE is treated as BASIC.
+inline char* write_sgr(char* out, byte f, byte b, const RGBA* palette, ColorSupport colors) {
+    *out++ = '\x1b';
+    *out++ = '[';
+    const byte index[2] = {f, b};
+    for(int i = 0; i < 2; i++) {
+        if(i) *out++ = ';';
+        if(index[i] == CELL_DEFAULT_COLOR) {
+            out = write_decimal(out, i ? 49 : 39);
+        } else if(colors == ColorSupport::TRUECOLOR) {
+            const RGBA& color = palette[index[i]];
+            memcpy(out, i ? "48;2;" : "38;2;", 5);
+            out = write_decimal(out + 5, color.r);
+            *out++ = ';';
+            out = write_decimal(out, color.g);
+            *out++ = ';';
+            out = write_decimal(out, color.b);
+        } else if(colors == ColorSupport::XTERM256) {
+            memcpy(out, i ? "48;5;" : "38;5;", 5);
+            out = write_decimal(out + 5, xterm256_index(palette[index[i]]));
+        } else {
+            out = write_decimal(out, ansi_color_code(index[i]) + (i ? 10 : 0));
+        }
+    }
+    *out++ = 'm';
+    return out;
+}
+
+// ANSI escape rendering of a cell grid laid out like rasterize_cells. A color
+// sequence is only emitted where fg or bg changes; every row ends with a
+// reset so the terminal's own colors are back before the newline. `colors`
+// picks how the palette is sent; BASIC means the 16 standard terminal colors.
+// The row buffer is sized for the worst case, a sequence before every cell,
+// so it is allocated once and written without bounds checks.
+inline void export_ansi(const char* glyphs, size_t stride, int columns, int rows, const byte* fg, const byte* bg, const RGBA* palette, ColorSupport colors, stbi_write_func* sink, void* context) {
+    std::string buffer(size_t(columns) * (SGR_MAX + 1) + sizeof(SGR_ROW_END) - 1, '\0');
+    for(int row = 0; row < rows; row++) {
+        const char* text = glyphs + size_t(row) * stride;
+        const byte* f = fg + size_t(row) * columns;
+        const byte* b = bg + size_t(row) * columns;
+        char* out = &buffer[0];
+        for(int start = 0, end; start < columns; start = end) {
+            for(end = start + 1; end < columns && f[end] == f[start] && b[end] == b[start]; end++) {}
+            out = write_sgr(out, f[start], b[start], palette, colors);
+            memcpy(out, text + start, end - start);
+            out += end - start;
+        }
+        memcpy(out, SGR_ROW_END, sizeof(SGR_ROW_END) - 1);
+        out += sizeof(SGR_ROW_END) - 1;
+        sink(context, &buffer[0], static_cast<int>(out - &buffer[0]));
+    }
+}
+
+#define ANSI_ALTERNATE_SCREEN "\x1b[?1049h\x1b[?25l"
+#define ANSI_MAIN_SCREEN "\x1b[0m\x1b[?25h\x1b[?1049l"
+#define ANSI_SYNC_BEGIN "\x1b[?2026h"
+#define ANSI_SYNC_END "\x1b[?2026l"
+
+// Flicker-free full-screen output for VT terminals, the counterpart of
+// Winsole's double buffering: the alternate screen stands in for the second
+// buffer, and every frame is a single write wrapped in a synchronized update
+// (DEC mode 2026), which terminals that know the mode show all at once and
+// the others simply ignore. leave() brings back the main screen untouched.
+class AnsiScreen {
+public:
+    AnsiScreen(stbi_write_func* sink, void* context) : sink(sink), context(context) {}
+    AnsiScreen(const AnsiScreen&) = delete;
+    AnsiScreen& operator=(const AnsiScreen&) = delete;
+    ~AnsiScreen() { leave(); }
+
+    void enter() {
+        if(active) return;
+        send(ANSI_ALTERNATE_SCREEN, sizeof(ANSI_ALTERNATE_SCREEN) - 1);
+        active = true;
+    }
+
+    void leave() {
+        if(!active) return;
+        send(ANSI_MAIN_SCREEN, sizeof(ANSI_MAIN_SCREEN) - 1);
+        active = false;
+    }
+
+    // Draws a columns x rows grid from the top left corner. Rows are placed
+    // with cursor moves rather than newlines, so a row as wide as the
+    // terminal cannot scroll it, and colors are only sent where they change;
+    // with NONE there are none to send, only the glyphs.
+    void present(const char* glyphs, const CellAttr* attrs, int columns, int rows, const RGBA* palette, ColorSupport colors) {
+        constexpr size_t MOVE_MAX = sizeof("\x1b[65535;1H") - 1;
+        buffer.resize(sizeof(ANSI_SYNC_BEGIN) - 1 + size_t(rows) * (MOVE_MAX + size_t(columns) * (SGR_MAX + 1)) +
+                      sizeof("\x1b[0m") - 1 + sizeof(ANSI_SYNC_END) - 1);
+        char* out = &buffer[0];
+        out = append(out, ANSI_SYNC_BEGIN, sizeof(ANSI_SYNC_BEGIN) - 1);
+        for(int row = 0; row < rows; row++) {
+            *out++ = '\x1b';
+            *out++ = '[';
+            out = write_decimal(out, row + 1);
+            out = append(out, ";1H", 3);
+            const char* text = glyphs + size_t(row) * columns;
+            const CellAttr* a = attrs + size_t(row) * columns;
+            for(int start = 0, end; start < columns; start = end) {
+                end = attr_run(a, start, columns);
+                if(colors != ColorSupport::NONE && ((row == 0 && start == 0) || a[start] != previous)) out = write_sgr(out, attr_fg(a[start]), attr_bg(a[start]), palette, colors);
+                previous = a[start];
+                out = append(out, text + start, end - start);
+            }
+        }
+        if(colors != ColorSupport::NONE) out = append(out, "\x1b[0m", 4);
+        out = append(out, ANSI_SYNC_END, sizeof(ANSI_SYNC_END) - 1);
+        send(buffer.data(), out - buffer.data());
+    }
+
+private:
+    stbi_write_func* sink;
+    void* context;
+    bool active = false;
+    CellAttr previous = 0;
+    std::string buffer;
+
+    static char* append(char* out, const char* text, size_t length) {
+        memcpy(out, text, length);
+        return out + length;
+    }
+
+    void send(const char* data, size_t size) {
+        sink(context, const_cast<char*>(data), static_cast<int>(size));
+    }
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+// stb/data/atari_8bit_font_revised.png as bytes, so rendering to an image
+// does not depend on where the program is started from or installed.
+constexpr unsigned char ATARI_FONT_PNG[] = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x03, 0xe7, 0x00, 0x00, 0x00, 0x09, 0x08, 0x00, 0x00, 0x00, 0x00, 0x75, 0x33, 0x02,
+    0x0f, 0x00, 0x00, 0x00, 0x09, 0x70, 0x48, 0x59, 0x73, 0x00, 0x00, 0x0b, 0x13, 0x00, 0x00, 0x0b,
+    0x13, 0x01, 0x00, 0x9a, 0x9c, 0x18, 0x00, 0x00, 0x03, 0x18, 0x69, 0x43, 0x43, 0x50, 0x50, 0x68,
+    0x6f, 0x74, 0x6f, 0x73, 0x68, 0x6f, 0x70, 0x20, 0x49, 0x43, 0x43, 0x20, 0x70, 0x72, 0x6f, 0x66,
+    0x69, 0x6c, 0x65, 0x00, 0x00, 0x78, 0xda, 0x63, 0x60, 0x60, 0x9e, 0xe0, 0xe8, 0xe2, 0xe4, 0xca,
+    0x24, 0xc0, 0xc0, 0x50, 0x50, 0x54, 0x52, 0xe4, 0x1e, 0xe4, 0x18, 0x19, 0x11, 0x19, 0xa5, 0xc0,
+    0x7e, 0x9e, 0x81, 0x8d, 0x81, 0x99, 0x81, 0x81, 0x81, 0x81, 0x81, 0x21, 0x31, 0xb9, 0xb8, 0xc0,
+    0x31, 0x20, 0xc0, 0x87, 0x81, 0x81, 0x81, 0x21, 0x2f, 0x3f, 0x2f, 0x95, 0x01, 0x15, 0x30, 0x32,
+    0x30, 0x7c, 0xbb, 0xc6, 0xc0, 0xc8, 0xc0, 0xc0, 0xc0, 0x70, 0x59, 0xd7, 0xd1, 0xc5, 0xc9, 0x95,
+    0x81, 0x34, 0xc0, 0x9a, 0x5c, 0x50, 0x54, 0xc2, 0xc0, 0xc0, 0x70, 0x80, 0x81, 0x81, 0xc1, 0x28,
+    0x25, 0xb5, 0x38, 0x99, 0x81, 0x81, 0xe1, 0x0b, 0x03, 0x03, 0x43, 0x7a, 0x79, 0x49, 0x41, 0x09,
+    0x03, 0x03, 0x63, 0x0c, 0x03, 0x03, 0x83, 0x48, 0x52, 0x76, 0x41, 0x09, 0x03, 0x03, 0x63, 0x01,
+    0x03, 0x03, 0x83, 0x48, 0x76, 0x48, 0x90, 0x33, 0x03, 0x03, 0x63, 0x0b, 0x03, 0x03, 0x13, 0x4f,
+    0x49, 0x6a, 0x45, 0x09, 0x03, 0x03, 0x03, 0x83, 0x73, 0x7e, 0x41, 0x65, 0x51, 0x66, 0x7a, 0x46,
+    0x89, 0x82, 0xa1, 0xa5, 0xa5, 0xa5, 0x82, 0x63, 0x4a, 0x7e, 0x52, 0xaa, 0x42, 0x70, 0x65, 0x71,
+    0x49, 0x6a, 0x6e, 0xb1, 0x82, 0x67, 0x5e, 0x72, 0x7e, 0x51, 0x41, 0x7e, 0x51, 0x62, 0x49, 0x6a,
+    0x0a, 0x03, 0x03, 0x03, 0xd4, 0x0e, 0x06, 0x06, 0x06, 0x06, 0x5e, 0x97, 0xfc, 0x12, 0x05, 0xf7,
+    0xc4, 0xcc, 0x3c, 0x05, 0x23, 0x03, 0x55, 0x06, 0x2a, 0x83, 0x88, 0xc8, 0x28, 0x05, 0x08, 0x0b,
+    0x11, 0x3e, 0x08, 0x31, 0x04, 0x48, 0x2e, 0x2d, 0x2a, 0x83, 0x07, 0x25, 0x03, 0x83, 0x00, 0x83,
+    0x02, 0x83, 0x01, 0x83, 0x03, 0x43, 0x00, 0x43, 0x22, 0x43, 0x3d, 0xc3, 0x02, 0x86, 0xa3, 0x0c,
+    0x6f, 0x18, 0xc5, 0x19, 0x5d, 0x18, 0x4b, 0x19, 0x57, 0x30, 0xde, 0x63, 0x12, 0x63, 0x0a, 0x62,
+    0x9a, 0xc0, 0x74, 0x81, 0x59, 0x98, 0x39, 0x92, 0x79, 0x21, 0xf3, 0x1b, 0x16, 0x4b, 0x96, 0x0e,
+    0x96, 0x5b, 0xac, 0x7a, 0xac, 0xad, 0xac, 0xf7, 0xd8, 0x2c, 0xd9, 0xa6, 0xb1, 0x7d, 0x63, 0x0f,
+    0x67, 0xdf, 0xcd, 0xa1, 0xc4, 0xd1, 0xc5, 0xf1, 0x85, 0x33, 0x91, 0xf3, 0x02, 0x97, 0x23, 0xd7,
+    0x16, 0x6e, 0x4d, 0xee, 0x05, 0x3c, 0x52, 0x3c, 0x53, 0x79, 0x85, 0x78, 0x27, 0xf1, 0x09, 0xf3,
+    0x4d, 0xe3, 0x97, 0xe1, 0x5f, 0x2c, 0xa0, 0x23, 0xb0, 0x43, 0xd0, 0x55, 0xf0, 0x8a, 0x50, 0xaa,
+    0xd0, 0x0f, 0xe1, 0x5e, 0x11, 0x15, 0x91, 0xbd, 0xa2, 0xe1, 0xa2, 0x5f, 0xc4, 0x26, 0x89, 0x1b,
+    0x89, 0x5f, 0x91, 0xa8, 0x90, 0x94, 0x93, 0x3c, 0x26, 0x95, 0x2f, 0x2d, 0x2d, 0x7d, 0x42, 0xa6,
+    0x4c, 0x56, 0x5d, 0xf6, 0x96, 0x5c, 0x9f, 0xbc, 0x8b, 0xfc, 0x1f, 0x85, 0xad, 0x8a, 0x85, 0x4a,
+    0x7a, 0x4a, 0x6f, 0x95, 0xd7, 0xaa, 0x14, 0xa8, 0x9a, 0xa8, 0xfe, 0x54, 0x3b, 0xa8, 0xde, 0xa5,
+    0x11, 0xaa, 0xa9, 0xa4, 0xf9, 0x41, 0xeb, 0x80, 0xf6, 0x24, 0x9d, 0x54, 0x5d, 0x2b, 0x3d, 0x41,
+    0xbd, 0x57, 0xfa, 0x47, 0x0c, 0x16, 0x18, 0xd6, 0x1a, 0xc5, 0x18, 0xdb, 0x9a, 0xc8, 0x9b, 0x32,
+    0x9b, 0xbe, 0x34, 0xbb, 0x60, 0xbe, 0xd3, 0x62, 0x89, 0xe5, 0x04, 0xab, 0x3a, 0xeb, 0x5c, 0x9b,
+    0x38, 0xdb, 0x40, 0x3b, 0x57, 0x7b, 0x6b, 0x07, 0x63, 0x47, 0x1d, 0x27, 0x35, 0x67, 0x25, 0x17,
+    0x05, 0x57, 0x79, 0x37, 0x05, 0x77, 0x65, 0x0f, 0x75, 0x4f, 0x5d, 0x2f, 0x13, 0x6f, 0x1b, 0x1f,
+    0x77, 0xdf, 0x60, 0xbf, 0x04, 0xff, 0xfc, 0x80, 0xfa, 0xc0, 0x89, 0x41, 0x4b, 0x83, 0x77, 0x85,
+    0x5c, 0x0c, 0x7d, 0x19, 0xce, 0x14, 0x21, 0x17, 0x69, 0x15, 0x15, 0x11, 0x5d, 0x11, 0x33, 0x33,
+    0x76, 0x4f, 0xdc, 0x83, 0x04, 0xb6, 0x44, 0xdd, 0xa4, 0xb0, 0xe4, 0x86, 0x94, 0x35, 0xa9, 0x37,
+    0xd3, 0x39, 0x32, 0x2c, 0x32, 0x33, 0xb3, 0xe6, 0x66, 0x5f, 0xcc, 0x65, 0xcf, 0xb3, 0xcf, 0xaf,
+    0x28, 0xd8, 0x54, 0xf8, 0xae, 0x58, 0xbb, 0x24, 0xab, 0x74, 0x55, 0xd9, 0x9b, 0x0a, 0xfd, 0xca,
+    0x92, 0xaa, 0x5d, 0x35, 0x8c, 0xb5, 0x5e, 0x75, 0x53, 0xeb, 0x1f, 0x36, 0xea, 0x35, 0xd5, 0x34,
+    0x9f, 0x6d, 0x95, 0x6b, 0x2b, 0x6c, 0x3f, 0xda, 0x29, 0xdd, 0x55, 0xd4, 0x7d, 0xba, 0x57, 0xb5,
+    0xaf, 0xb1, 0xff, 0xee, 0x44, 0x9b, 0x49, 0xb3, 0x27, 0xff, 0x9d, 0x1a, 0x3f, 0xed, 0xf0, 0x0c,
+    0x8d, 0x99, 0xfd, 0xb3, 0xbe, 0xcf, 0x49, 0x98, 0x7b, 0x7a, 0xbe, 0xf9, 0x82, 0xa5, 0x8b, 0x44,
+    0x16, 0xb7, 0x2e, 0xf9, 0xb6, 0x2c, 0x73, 0xf9, 0xbd, 0x95, 0x21, 0xab, 0x4e, 0xaf, 0x71, 0x59,
+    0xbb, 0x6f, 0xbd, 0xe5, 0x86, 0x6d, 0x9b, 0x4c, 0x36, 0x6f, 0xd9, 0x6a, 0xb2, 0x6d, 0xfb, 0x0e,
+    0xab, 0x9d, 0xfb, 0x77, 0xbb, 0xee, 0x39, 0xbb, 0x2f, 0x6c, 0xff, 0x83, 0x83, 0x39, 0x87, 0x7e,
+    0x1e, 0x69, 0x3f, 0x26, 0x7e, 0x7c, 0xc5, 0x49, 0xeb, 0x53, 0xe7, 0xce, 0x24, 0x9f, 0xfd, 0x75,
+    0x7e, 0xd2, 0x45, 0xed, 0x4b, 0x47, 0xaf, 0x24, 0x5e, 0xfd, 0x77, 0x7d, 0xce, 0x4d, 0x9b, 0x5b,
+    0x77, 0xef, 0xd4, 0xdf, 0x53, 0xbe, 0x7f, 0xe2, 0x61, 0xde, 0x63, 0xb1, 0x27, 0xfb, 0x9f, 0x65,
+    0xbe, 0x10, 0x79, 0x79, 0xf0, 0x75, 0xfe, 0x5b, 0xf9, 0x77, 0x17, 0x3e, 0x34, 0x7d, 0x32, 0xfd,
+    0xfc, 0xea, 0xeb, 0x82, 0xef, 0xe1, 0x3f, 0x05, 0x7e, 0x9d, 0xfa, 0xd3, 0xfa, 0xcf, 0xf1, 0xff,
+    0x7f, 0x00, 0x0d, 0x00, 0x0f, 0x34, 0xfa, 0x96, 0xf1, 0x5d, 0x00, 0x00, 0x00, 0x20, 0x63, 0x48,
+    0x52, 0x4d, 0x00, 0x00, 0x7a, 0x25, 0x00, 0x00, 0x80, 0x83, 0x00, 0x00, 0xf9, 0xff, 0x00, 0x00,
+    0x80, 0xe9, 0x00, 0x00, 0x75, 0x30, 0x00, 0x00, 0xea, 0x60, 0x00, 0x00, 0x3a, 0x98, 0x00, 0x00,
+    0x17, 0x6f, 0x92, 0x5f, 0xc5, 0x46, 0x00, 0x00, 0x03, 0x4b, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda,
+    0xec, 0x59, 0xd1, 0x92, 0xa3, 0x30, 0x0c, 0xf3, 0xff, 0xff, 0xb4, 0xee, 0xa5, 0x4d, 0x6c, 0x49,
+    0x76, 0x80, 0xee, 0xde, 0xcd, 0xcd, 0x94, 0x6e, 0x59, 0x4a, 0x20, 0x31, 0x8e, 0x25, 0xcb, 0x21,
+    0x62, 0x6d, 0x90, 0x43, 0xbc, 0xfe, 0xf0, 0xde, 0x22, 0xec, 0xe5, 0xb1, 0x5b, 0x90, 0x7f, 0xbf,
+    0xbb, 0x01, 0xd6, 0x3e, 0xf7, 0x7d, 0xdc, 0xb0, 0x7b, 0x7b, 0x75, 0x51, 0xce, 0xbd, 0xff, 0x21,
+    0x8d, 0x92, 0xad, 0x81, 0x1c, 0xdc, 0xdd, 0xf0, 0xba, 0x1b, 0xd2, 0xf1, 0x6a, 0xa9, 0x6d, 0xfb,
+    0x8c, 0x5e, 0xb3, 0xae, 0xc5, 0x68, 0x0f, 0xb5, 0xa5, 0xa7, 0x92, 0xdb, 0xd3, 0x09, 0x88, 0x61,
+    0x51, 0x46, 0xaf, 0x66, 0xa0, 0x7a, 0x15, 0xe4, 0x3b, 0xda, 0x05, 0xbb, 0x7f, 0xdf, 0x26, 0xa3,
+    0xfb, 0x33, 0x6b, 0x8c, 0xfc, 0xa5, 0x9d, 0xce, 0xb2, 0x71, 0x66, 0x72, 0xcb, 0x36, 0xf9, 0xe0,
+    0xc1, 0xf0, 0xde, 0x3e, 0xc6, 0xc4, 0xd3, 0xa0, 0xf9, 0x17, 0x9b, 0x09, 0x89, 0x3e, 0xa6, 0x41,
+    0x87, 0x60, 0x7c, 0xa3, 0xb9, 0x3c, 0x5f, 0x81, 0xc5, 0x0f, 0x0c, 0xf7, 0xc2, 0x01, 0x78, 0x80,
+    0xf3, 0x64, 0x8d, 0x04, 0x6b, 0x00, 0xd1, 0x3f, 0x2b, 0x5f, 0x7c, 0x67, 0xfc, 0x3c, 0x04, 0xf1,
+    0x8e, 0x0e, 0x26, 0x5c, 0xd3, 0xa0, 0xa4, 0xb2, 0x55, 0x21, 0x4a, 0x5c, 0x26, 0x3b, 0xa4, 0x41,
+    0x65, 0x88, 0xce, 0x9e, 0x72, 0xc0, 0x66, 0x98, 0x21, 0xb6, 0x03, 0x5f, 0x40, 0x75, 0x90, 0x1c,
+    0x10, 0x5b, 0x1f, 0xe3, 0x16, 0xce, 0x35, 0x5a, 0xb4, 0x43, 0x17, 0xd2, 0x0f, 0x71, 0x8e, 0x8e,
+    0x61, 0xe5, 0x88, 0x03, 0xeb, 0x47, 0x80, 0xfa, 0x33, 0x77, 0xfb, 0x00, 0xe4, 0xe4, 0x85, 0x26,
+    0x9f, 0xaf, 0x4f, 0x20, 0x65, 0x39, 0x7d, 0x58, 0xa4, 0xf6, 0x14, 0xfc, 0x69, 0x80, 0xc5, 0xeb,
+    0x26, 0xa9, 0xe1, 0x72, 0x3e, 0x1f, 0xe7, 0xbb, 0x0f, 0x0a, 0xe0, 0x82, 0x1b, 0x4c, 0x68, 0x42,
+    0xf0, 0x60, 0x60, 0x0e, 0x4a, 0x60, 0xcf, 0x70, 0xce, 0x92, 0x21, 0x5c, 0xcc, 0xa3, 0xe9, 0x50,
+    0x31, 0xfc, 0x18, 0xe7, 0xd4, 0x82, 0x3c, 0x71, 0xbf, 0x83, 0x73, 0xa5, 0xad, 0x98, 0xf8, 0x30,
+    0x35, 0xf5, 0xd4, 0x48, 0x93, 0x12, 0x5e, 0x68, 0xa8, 0xe7, 0xe9, 0xb6, 0x01, 0x94, 0x1a, 0xa2,
+    0x18, 0x47, 0x1f, 0x14, 0x10, 0x27, 0xb5, 0x89, 0x4f, 0x45, 0xef, 0x44, 0x1f, 0x48, 0x1c, 0xec,
+    0x48, 0x8f, 0xc8, 0x38, 0x5f, 0x3b, 0x24, 0xb1, 0x8c, 0x7d, 0x9f, 0xc2, 0x1c, 0x4e, 0xa0, 0xd6,
+    0x44, 0x91, 0x72, 0xf4, 0x75, 0x62, 0x1e, 0xa6, 0x67, 0xb8, 0xdb, 0xc9, 0x81, 0x8a, 0x44, 0x9d,
+    0x54, 0x96, 0xbe, 0x03, 0x6a, 0x4a, 0xb0, 0xd1, 0x5c, 0x4a, 0xd8, 0x0d, 0x01, 0xe4, 0xe9, 0x47,
+    0x4a, 0x15, 0x27, 0xbc, 0xa3, 0xc1, 0xb9, 0x21, 0x20, 0x1b, 0x5b, 0x6c, 0xbc, 0x44, 0xcb, 0x82,
+    0xf7, 0x56, 0xe0, 0xdb, 0xad, 0xc4, 0x66, 0xa6, 0x42, 0x19, 0x70, 0x0e, 0x15, 0x0f, 0x2d, 0x65,
+    0xdb, 0xd4, 0x3a, 0xe4, 0xae, 0x0b, 0x3c, 0xd8, 0x94, 0x33, 0xc5, 0x89, 0x86, 0xfa, 0x4d, 0x90,
+    0xa0, 0x23, 0xdf, 0x13, 0x2f, 0x1b, 0xd3, 0xd2, 0x17, 0x27, 0x1e, 0x74, 0xfd, 0x84, 0x96, 0x96,
+    0x51, 0x51, 0x9d, 0x2b, 0xde, 0xb7, 0xfd, 0xaf, 0x4f, 0x3e, 0xb1, 0x01, 0xbf, 0x95, 0x2b, 0x65,
+    0x7b, 0x85, 0x4e, 0xad, 0xcf, 0x71, 0x8d, 0x3e, 0x0d, 0xce, 0x9d, 0xa2, 0x93, 0x05, 0x84, 0xcf,
+    0xf2, 0x79, 0x95, 0xac, 0x9d, 0x52, 0x30, 0xde, 0x1c, 0x96, 0x12, 0x0c, 0x3f, 0xdc, 0xc8, 0xe7,
+    0xa6, 0x60, 0x7f, 0x96, 0xcf, 0x5b, 0x59, 0x31, 0xe4, 0xf3, 0xca, 0xcd, 0x8d, 0xc4, 0x5e, 0xb1,
+    0xae, 0xc0, 0xd4, 0x12, 0x23, 0xbb, 0x0e, 0x33, 0xbc, 0x3b, 0x40, 0x1c, 0x8b, 0xd6, 0xb3, 0x7f,
+    0x98, 0xec, 0x0c, 0xce, 0x2d, 0x78, 0xe2, 0x33, 0x9c, 0x77, 0x8c, 0x66, 0x70, 0xce, 0x34, 0x6e,
+    0x26, 0xae, 0xcd, 0xe7, 0x9a, 0xcd, 0x17, 0xb8, 0x93, 0x84, 0xef, 0xf3, 0x79, 0xa1, 0x79, 0x5e,
+    0x9c, 0x4a, 0x82, 0x1d, 0xa3, 0x32, 0x47, 0xa9, 0x6c, 0x81, 0xbe, 0x42, 0x2a, 0xbc, 0x43, 0x39,
+    0x44, 0x23, 0x2e, 0x6e, 0xd4, 0xe7, 0x40, 0x2b, 0xd7, 0x3b, 0x7d, 0xeb, 0x9a, 0xa2, 0xb7, 0xc7,
+    0xe0, 0x7c, 0xb0, 0xa2, 0x97, 0x25, 0x2c, 0x2c, 0xe7, 0x48, 0x9a, 0xea, 0xf3, 0x93, 0x85, 0xae,
+    0x3e, 0x9f, 0x07, 0x8c, 0x98, 0x0b, 0x6c, 0x87, 0x1d, 0x70, 0xe5, 0xdf, 0xfa, 0xb9, 0xa9, 0xd3,
+    0xe2, 0x62, 0x56, 0xb8, 0xc2, 0x83, 0x37, 0x71, 0x6e, 0x0a, 0x0b, 0xc4, 0x7d, 0x9c, 0x4f, 0x31,
+    0x65, 0x94, 0x18, 0xab, 0xc7, 0x29, 0x7c, 0x0e, 0x0b, 0x71, 0x58, 0x85, 0x35, 0xa6, 0xfa, 0x1c,
+    0x5b, 0xb1, 0xdb, 0xb2, 0x06, 0x26, 0x83, 0x07, 0x57, 0x52, 0xb4, 0x4c, 0x77, 0x56, 0xb1, 0x26,
+    0x14, 0x32, 0xc7, 0xb6, 0x40, 0x9f, 0x84, 0x42, 0x8b, 0x73, 0x59, 0xda, 0x6d, 0xd6, 0xae, 0x07,
+    0x71, 0xde, 0xa4, 0x68, 0x00, 0xe7, 0x8a, 0x2f, 0x8e, 0x0c, 0x70, 0xa8, 0x09, 0x35, 0xe7, 0xb7,
+    0x34, 0xa1, 0xef, 0x08, 0x82, 0xda, 0xc6, 0xf5, 0xf6, 0xec, 0x6f, 0x8a, 0xf5, 0xde, 0x3f, 0xe1,
+    0x95, 0x82, 0xaf, 0x98, 0x4a, 0x06, 0x40, 0xf8, 0x92, 0x50, 0xdf, 0x08, 0xd9, 0x7a, 0xf8, 0x46,
+    0x7d, 0xae, 0xe5, 0xa7, 0x61, 0x2b, 0x34, 0x4f, 0x31, 0xd5, 0xe7, 0x64, 0x20, 0x07, 0x2b, 0xa7,
+    0x6f, 0xe5, 0x65, 0x15, 0x23, 0x97, 0xd7, 0xdb, 0xdf, 0xa2, 0x8b, 0x17, 0xcd, 0xfc, 0x7a, 0x3b,
+    0xd6, 0x25, 0x62, 0xb3, 0x4c, 0x0a, 0x75, 0x19, 0x17, 0x5e, 0x2e, 0xfd, 0xc5, 0x17, 0x12, 0xf1,
+    0xb5, 0xe2, 0xbb, 0x5d, 0x9d, 0x8e, 0x07, 0x13, 0x05, 0xfc, 0xc2, 0x44, 0x7f, 0xb8, 0x3c, 0x6f,
+    0x57, 0xe0, 0xfd, 0xfb, 0x73, 0x4c, 0x2a, 0xd9, 0xbd, 0xb0, 0xc0, 0x37, 0x98, 0xbf, 0xdb, 0x7f,
+    0x01, 0xf2, 0x7e, 0x91, 0xf4, 0x49, 0x08, 0xff, 0x38, 0xce, 0xf1, 0xc4, 0x8e, 0x3f, 0x00, 0x00,
+    0x00, 0xff, 0xff, 0x03, 0x00, 0x52, 0xe0, 0xe3, 0x8d, 0xef, 0xa5, 0x4f, 0x45, 0x00, 0x00, 0x00,
+    0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+};
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#define CACHE_TEMP_SUFFIX ".tmp"
+
+inline uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// XXH64. Used where whole inputs are hashed, at several GB/s.
+inline uint64_t xxh64(const void* data, size_t size, uint64_t seed = 0) {
+    const uint64_t P1 = 0x9E3779B185EBCA87ull, P2 = 0xC2B2AE3D27D4EB4Full, P3 = 0x165667B19E3779F9ull;
+    const uint64_t P4 = 0x85EBCA77C2B2AE63ull, P5 = 0x27D4EB2F165667C5ull;
+    auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+    auto round = [&](uint64_t acc, uint64_t input) { return rotl(acc + input * P2, 31) * P1; };
+    auto merge = [&](uint64_t acc, uint64_t value) { return (acc ^ round(0, value)) * P1 + P4; };
+    auto read64 = [](const unsigned char* p) { uint64_t v; memcpy(&v, p, 8); return v; };
+    auto read32 = [](const unsigned char* p) { uint32_t v; memcpy(&v, p, 4); return uint64_t(v); };
+
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    uint64_t hash;
+    if(size >= 32) {
+        uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+        for(; p + 32 <= end; p += 32) {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = merge(merge(merge(merge(hash, v1), v2), v3), v4);
+    } else {
+        hash = seed + P5;
+    }
+    hash += size;
+    for(; p + 8 <= end; p += 8) hash = rotl(hash ^ round(0, read64(p)), 27) * P1 + P4;
+    if(p + 4 <= end) {
+        hash = rotl(hash ^ (read32(p) * P1), 23) * P2 + P3;
+        p += 4;
+    }
+    for(; p < end; p++) hash = rotl(hash ^ (*p * P5), 11) * P1;
+
+    hash ^= hash >> 33;
+    hash *= P2;
+    hash ^= hash >> 29;
+    hash *= P3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+inline std::string hex64(uint64_t value) {
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+    return buffer;
+}
+
+// ASCIIMAGE_CACHE, else the system temp directory.
+inline std::string cache_directory() {
+    const char* names[] = {"ASCIIMAGE_CACHE", "TEMP", "TMP", "TMPDIR"};
+    for(const char* name : names) {
+        const char* dir = getenv(name);
+        if(dir && *dir) return dir;
+    }
+#ifdef _WIN32
+    return ".";
+#else
+    return "/tmp";
+#endif
+}
+
+inline std::string cache_path(const std::string& name) {
+    return cache_directory() + "/" + name;
+}
+
+inline bool read_file(const std::string& path, std::vector<unsigned char>& bytes) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if(!file) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    bytes.resize(size > 0 ? size : 0);
+    bool ok = size >= 0 && fread(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    fclose(file);
+    return ok;
+}
+
+// Writes to a temporary name first so readers never see a partial file. The
+// name is unique per process and call, so concurrent writers of one path
+// never share it, and the rename replaces `path` in one step: rename() on
+// POSIX, MoveFileEx on Windows, where rename() refuses an existing target.
+inline bool write_file_atomic(const std::string& path, const void* data, size_t size) {
+    static std::atomic<unsigned> counter{0};
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+    std::string temp = path + "." + std::to_string(pid) + "." + std::to_string(counter++) + CACHE_TEMP_SUFFIX;
+    FILE* file = fopen(temp.c_str(), "wb");
+    if(!file) return false;
+    bool ok = fwrite(data, 1, size, file) == size;
+    ok = (fclose(file) == 0) && ok;
+    if(ok) {
+#ifdef _WIN32
+        ok = MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        ok = rename(temp.c_str(), path.c_str()) == 0;
+#endif
+    }
+    if(!ok) remove(temp.c_str());
+    return ok;
+}
+
+// Read-only view of a whole file. Empty files open but map nothing.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER length;
+        bool ok = GetFileSizeEx(file, &length) != 0;
+        mapped = ok ? static_cast<size_t>(length.QuadPart) : 0;
+        if(ok && mapped) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            view = mapping ? static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+            ok = view != nullptr;
+        }
+        CloseHandle(file);
+#else
+        int file = ::open(path.c_str(), O_RDONLY);
+        if(file < 0) return false;
+        struct stat status;
+        bool ok = fstat(file, &status) == 0;
+        mapped = ok ? static_cast<size_t>(status.st_size) : 0;
+        if(ok && mapped) {
+            void* address = mmap(nullptr, mapped, PROT_READ, MAP_PRIVATE, file, 0);
+            view = address == MAP_FAILED ? nullptr : static_cast<const unsigned char*>(address);
+            ok = view != nullptr;
+        }
+        ::close(file);
+#endif
+        if(!ok) close();
+        return ok;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if(view) UnmapViewOfFile(view);
+        if(mapping) CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        if(view) munmap(const_cast<unsigned char*>(view), mapped);
+#endif
+        view = nullptr;
+        mapped = 0;
+    }
+
+    const unsigned char* data() const { return view; }
+    size_t size() const { return mapped; }
+
+private:
+    const unsigned char* view = nullptr;
+    size_t mapped = 0;
+#ifdef _WIN32
+    HANDLE mapping = nullptr;
+#endif
+};
+
+// Marks a cache entry as just used, for least-recently-used eviction.
+inline void touch_file(const std::string& path) {
+    std::error_code error;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+}
+
+// Deletes the least recently used cache files named <prefix>* until the rest
+// fit in `limit` bytes, and returns the bytes left. Files still being
+// written by write_file_atomic are left alone.
+inline uint64_t prune_cache(const std::string& prefix, uint64_t limit) {
+    struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type time;
+        uint64_t size;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code error;
+    for(const auto& file : std::filesystem::directory_iterator(cache_directory(), error)) {
+        std::string name = file.path().filename().string();
+        if(name.compare(0, prefix.size(), prefix) != 0 || !file.is_regular_file(error)) continue;
+        if(name.size() >= sizeof(CACHE_TEMP_SUFFIX) - 1 && name.compare(name.size() - (sizeof(CACHE_TEMP_SUFFIX) - 1), std::string::npos, CACHE_TEMP_SUFFIX) == 0) continue;
+        Entry entry = {file.path(), file.last_write_time(error), file.file_size(error)};
+        if(error) continue;
+        entries.push_back(entry);
+        total += entry.size;
+    }
+    if(total <= limit) return total;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    for(const Entry& entry : entries) {
+        if(total <= limit) break;
+        if(std::filesystem::remove(entry.path, error)) total -= entry.size;
+    }
+    return total;
+}
+
+// Keeps a cache prefix under its limit across many stores with as few
+// directory scans as possible: the total from the last scan is carried
+// forward by the size of each new entry, and the directory is scanned and
+// pruned again only once that estimate passes the limit. Overwritten entries
+// are counted twice, which only brings the next scan forward.
+class CachePruner {
+public:
+    CachePruner(std::string prefix, uint64_t limit) : prefix(std::move(prefix)), limit(limit) {}
+
+    void stored(uint64_t bytes) {
+        if(scanned && total + bytes <= limit) {
+            total += bytes;
+            return;
+        }
+        total = prune_cache(prefix, limit);
+        scanned = true;
+    }
+
+private:
+    std::string prefix;
+    uint64_t limit;
+    uint64_t total = 0;
+    bool scanned = false;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "image.hpp"
+
+// A console cell's colors packed the way a Windows wAttributes word holds
+// them (see Winsole::set_colors): fg index in the low nibble, bg in the next
+// one, so the low byte is the console attribute as is. The two bits above it
+// leave a channel in the terminal's own color, which ANSI can ask for and
+// the Windows console cannot; its backend resolves them before drawing.
+typedef uint16_t CellAttr;
+
+// Stands for the terminal's own color wherever cell_attr takes or attr_fg
+// and attr_bg give a color index; .asf frames store the same byte.
+constexpr byte CELL_DEFAULT_COLOR = 0xff;
+constexpr CellAttr CELL_DEFAULT_FG = 0x100, CELL_DEFAULT_BG = 0x200;
+
+inline CellAttr cell_attr(byte fg, byte bg) {
+    return static_cast<CellAttr>((fg == CELL_DEFAULT_COLOR ? CELL_DEFAULT_FG : fg & 0x0F) |
+                                 (bg == CELL_DEFAULT_COLOR ? CELL_DEFAULT_BG : (bg & 0x0F) << 4));
+}
+
+inline byte attr_fg(CellAttr attr) { return attr & CELL_DEFAULT_FG ? CELL_DEFAULT_COLOR : attr & 0x0F; }
+inline byte attr_bg(CellAttr attr) { return attr & CELL_DEFAULT_BG ? CELL_DEFAULT_COLOR : (attr >> 4) & 0x0F; }
+
+// End of the run of equal attributes that starts at `start`.
+inline int attr_run(const CellAttr* attrs, int start, int end) {
+    int x = start + 1;
+    while(x < end && attrs[x] == attrs[start]) x++;
+    return x;
+}
+
+// A frame of console cells as two planes, glyphs and attributes, columns x
+// rows without row separators. Storage is kept across resize() calls, so a
+// reused grid stops allocating once it has seen the largest frame.
+struct CellGrid {
+    int columns = 0, rows = 0;
+    std::vector<char> glyphs;
+    std::vector<CellAttr> attrs;
+
+    void resize(int c, int r) {
+        columns = c;
+        rows = r;
+        glyphs.resize(cells());
+        attrs.resize(cells());
+    }
+
+    size_t cells() const { return size_t(columns) * rows; }
+    char* glyph_row(int y) { return glyphs.data() + size_t(y) * columns; }
+    const char* glyph_row(int y) const { return glyphs.data() + size_t(y) * columns; }
+    CellAttr* attr_row(int y) { return attrs.data() + size_t(y) * columns; }
+    const CellAttr* attr_row(int y) const { return attrs.data() + size_t(y) * columns; }
+
+    // From separate fg/bg index planes, as stored in .asf frames.
+    void assign(const char* text, size_t stride, int c, int r, const byte* fg, const byte* bg) {
+        resize(c, r);
+        for(int y = 0; y < r; y++) {
+            const char* in = text + size_t(y) * stride;
+            std::copy(in, in + c, glyph_row(y));
+            size_t cell = size_t(y) * c;
+            CellAttr* out = attr_row(y);
+            for(int x = 0; x < c; x++) out[x] = cell_attr(fg[cell + x], bg[cell + x]);
+        }
+    }
+};
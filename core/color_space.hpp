@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "image.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define ASCIIMAGE_SSE2 1
+#endif
+
+struct Oklab {
+    float L, a, b;
+};
+
+struct SrgbLinearTable {
+    float values[256];
+
+    SrgbLinearTable() {
+        for(int i = 0; i < 256; i++) {
+            float c = i / 255.0f;
+            values[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+    }
+};
+
+// sRGB byte -> linear light, built once.
+inline const float* srgb_to_linear_table() {
+    static const SrgbLinearTable table;
+    return table.values;
+}
+
+// Cube root from an exponent bit trick refined by two Newton steps,
+// accurate to ~1e-6 for the [0, 1] range the LMS responses live in.
+inline float fast_cbrt(float x) {
+    if(x <= 0.0f) return 0.0f;
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    bits = bits / 3 + 709921077u;
+    float y;
+    std::memcpy(&y, &bits, sizeof(y));
+    y = (2.0f * y + x / (y * y)) * (1.0f / 3.0f);
+    y = (2.0f * y + x / (y * y)) * (1.0f / 3.0f);
+    return y;
+}
+
+inline Oklab linear_to_oklab(float r, float g, float b) {
+    float l = fast_cbrt(0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b);
+    float m = fast_cbrt(0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+    float s = fast_cbrt(0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+    return {
+        0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s,
+        1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s,
+        0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s
+    };
+}
+
+inline Oklab srgb_to_oklab(const RGBA& color) {
+    const float* linear = srgb_to_linear_table();
+    return linear_to_oklab(linear[color.r], linear[color.g], linear[color.b]);
+}
+
+inline float oklab_distance(const Oklab& x, const Oklab& y) {
+    float dL = x.L - y.L, da = x.a - y.a, db = x.b - y.b;
+    return dL * dL + da * da + db * db;
+}
+
+#ifdef ASCIIMAGE_SSE2
+inline __m128 fast_cbrt_ps(__m128 x) {
+    __m128 positive = _mm_cmpgt_ps(x, _mm_setzero_ps());
+    x = _mm_max_ps(x, _mm_set1_ps(1e-30f));
+    // Unsigned bits / 3 on values below 2^31 (positive floats) equals the signed form.
+    __m128i bits = _mm_castps_si128(x);
+    __m128 third = _mm_set1_ps(1.0f / 3.0f);
+    __m128 approx = _mm_mul_ps(_mm_cvtepi32_ps(bits), third);
+    __m128 y = _mm_castsi128_ps(_mm_add_epi32(_mm_cvttps_epi32(approx), _mm_set1_epi32(709921077)));
+    __m128 two = _mm_set1_ps(2.0f);
+    y = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(two, y), _mm_div_ps(x, _mm_mul_ps(y, y))), third);
+    y = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(two, y), _mm_div_ps(x, _mm_mul_ps(y, y))), third);
+    return _mm_and_ps(y, positive);
+}
+#endif
+
+// Converts `count` colors into planar L/a/b arrays, four at a time when SSE2 is available.
+inline void srgb_to_oklab_planes(const RGBA* colors, size_t count, float* L, float* A, float* B) {
+    const float* linear = srgb_to_linear_table();
+    size_t i = 0;
+#ifdef ASCIIMAGE_SSE2
+    for(; i + 4 <= count; i += 4) {
+        const RGBA* c = colors + i;
+        __m128 r = _mm_setr_ps(linear[c[0].r], linear[c[1].r], linear[c[2].r], linear[c[3].r]);
+        __m128 g = _mm_setr_ps(linear[c[0].g], linear[c[1].g], linear[c[2].g], linear[c[3].g]);
+        __m128 b = _mm_setr_ps(linear[c[0].b], linear[c[1].b], linear[c[2].b], linear[c[3].b]);
+        auto dot = [&](float x, float y, float z) {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(x)), _mm_mul_ps(g, _mm_set1_ps(y))), _mm_mul_ps(b, _mm_set1_ps(z)));
+        };
+        __m128 l = fast_cbrt_ps(dot(0.4122214708f, 0.5363325363f, 0.0514459929f));
+        __m128 m = fast_cbrt_ps(dot(0.2119034982f, 0.6806995451f, 0.1073969566f));
+        __m128 s = fast_cbrt_ps(dot(0.0883024619f, 0.2817188376f, 0.6299787005f));
+        auto mix = [&](float x, float y, float z) {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(l, _mm_set1_ps(x)), _mm_mul_ps(m, _mm_set1_ps(y))), _mm_mul_ps(s, _mm_set1_ps(z)));
+        };
+        _mm_storeu_ps(L + i, mix(0.2104542553f, 0.7936177850f, -0.0040720468f));
+        _mm_storeu_ps(A + i, mix(1.9779984951f, -2.4285922050f, 0.4505937099f));
+        _mm_storeu_ps(B + i, mix(0.0259040371f, 0.7827717662f, -0.8086757660f));
+    }
+#endif
+    for(; i < count; i++) {
+        Oklab lab = srgb_to_oklab(colors[i]);
+        L[i] = lab.L;
+        A[i] = lab.a;
+        B[i] = lab.b;
+    }
+}
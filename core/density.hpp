@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <thread>
+#include <vector>
+#include "image.hpp"
+
+// One row of the plain density mapping: a glyph per pixel, or a space where
+// `opaque` (may be null) marks the pixel transparent.
+inline void density_row(const byte* lightness, const byte* opaque, const std::array<char, 256>& glyphs, char* out, int width) {
+    if(!opaque) {
+        for(int x = 0; x < width; x++) out[x] = glyphs[lightness[x]];
+        return;
+    }
+    for(int x = 0; x < width; x++) out[x] = opaque[x] ? glyphs[lightness[x]] : ' ';
+}
+
+// The output is sized exactly, width + 1 bytes per row without a trailing
+// newline, and row y starts at y * (width + 1), so rows are independent and
+// large images are split into bands across threads. `output` keeps its
+// capacity between calls.
+inline void density_ascii_image(const byte* lightness, const byte* opaque, int width, int height, const std::array<char, 256>& glyphs, std::string& output) {
+    if(width <= 0 || height <= 0) {
+        output.clear();
+        return;
+    }
+    output.resize(size_t(width + 1) * height - 1);
+    char* text = &output[0];
+
+    auto render_rows = [&](int first, int last) {
+        for(int y = first; y < last; y++) {
+            size_t offset = size_t(y) * width;
+            char* out = text + size_t(y) * (width + 1);
+            density_row(lightness + offset, opaque ? opaque + offset : nullptr, glyphs, out, width);
+            if(y + 1 < height) out[width] = '\n';
+        }
+    };
+
+    // Below this many pixels per thread the spawn costs more than it saves.
+    constexpr size_t MIN_PER_THREAD = 1 << 18;
+    size_t threads = std::thread::hardware_concurrency();
+    if(threads > size_t(width) * height / MIN_PER_THREAD) threads = size_t(width) * height / MIN_PER_THREAD;
+    if(threads < 1) threads = 1;
+
+    std::vector<std::thread> workers;
+    for(size_t t = 1; t < threads; t++)
+        workers.emplace_back(render_rows, int(t * height / threads), int((t + 1) * height / threads));
+    render_rows(0, int(height / threads));
+    for(std::thread& worker : workers)
+        worker.join();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "image.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+constexpr int DEFAULT_EDGE_THRESHOLD = 384;
+
+// Picks a line glyph for a Sobel gradient, or 0 when the edge is too weak.
+// The edge runs perpendicular to the gradient; tan(22.5 deg) ~ 106 / 256
+// splits the four orientations without an atan2.
+inline char edge_glyph(int gx, int gy, int threshold) {
+    int ax = std::abs(gx), ay = std::abs(gy);
+    if(ax + ay < threshold) return 0;
+    if(ay * 256 < ax * 106) return '|';
+    if(ax * 256 < ay * 106) return gy < 0 ? '_' : '-';
+    return ((gx > 0) == (gy > 0)) ? '/' : '\\';
+}
+
+// Vertical Sobel pass over three rows of the horizontal ones: gx = d0 + 2 d1
+// + d2 and gy = s2 - s0, 8 pixels a step. Both stay within +-1020.
+inline void sobel_row(const int16_t* d0, const int16_t* d1, const int16_t* d2, const int16_t* s0, const int16_t* s2, int16_t* gx, int16_t* gy, int width) {
+    int x = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    for(; x + 8 <= width; x += 8) {
+        auto load = [x](const int16_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + x)); };
+        __m128i center = load(d1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(gx + x), _mm_add_epi16(_mm_add_epi16(load(d0), load(d2)), _mm_add_epi16(center, center)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(gy + x), _mm_sub_epi16(load(s2), load(s0)));
+    }
+#endif
+    for(; x < width; x++) {
+        gx[x] = static_cast<int16_t>(d0[x] + 2 * d1[x] + d2[x]);
+        gy[x] = static_cast<int16_t>(s2[x] - s0[x]);
+    }
+}
+
+// Density mapping with a separable Sobel overlay in the same pass. Each
+// source row gets its horizontal [-1 0 1] and [1 2 1] passes exactly once,
+// kept in a 3-row ring, so the working set is eight short rows that stay in
+// L1 while the vertical pass and the glyph lookup run over them.
+inline std::string edge_ascii_image(const byte* lightness, int width, int height, const std::array<char, 256>& glyphs, const std::vector<byte>& opaque, int threshold) {
+    std::string output;
+    if(width <= 0 || height <= 0) return output;
+    output.resize(size_t(width + 1) * height - 1, '\n');
+
+    std::vector<int16_t> diff(size_t(width) * 3), smooth(size_t(width) * 3), gx(width), gy(width);
+    auto horizontal = [&](int y) {
+        y = y < 0 ? 0 : (y >= height ? height - 1 : y);
+        const byte* row = lightness + size_t(y) * width;
+        int16_t* d = &diff[size_t(y % 3) * width];
+        int16_t* s = &smooth[size_t(y % 3) * width];
+        for(int x = 1; x < width - 1; x++) {
+            d[x] = static_cast<int16_t>(row[x + 1] - row[x - 1]);
+            s[x] = static_cast<int16_t>(row[x - 1] + 2 * row[x] + row[x + 1]);
+        }
+        d[0] = static_cast<int16_t>(row[width > 1 ? 1 : 0] - row[0]);
+        s[0] = static_cast<int16_t>(3 * row[0] + row[width > 1 ? 1 : 0]);
+        if(width > 1) {
+            d[width - 1] = static_cast<int16_t>(row[width - 1] - row[width - 2]);
+            s[width - 1] = static_cast<int16_t>(row[width - 2] + 3 * row[width - 1]);
+        }
+    };
+
+    horizontal(0);
+    if(height > 1) horizontal(1);
+    for(int y = 0; y < height; y++) {
+        if(y + 1 < height && y >= 1) horizontal(y + 1);
+        int above = (y > 0 ? y - 1 : 0) % 3, center = y % 3, below = (y + 1 < height ? y + 1 : y) % 3;
+        sobel_row(&diff[size_t(above) * width], &diff[size_t(center) * width], &diff[size_t(below) * width],
+                  &smooth[size_t(above) * width], &smooth[size_t(below) * width], gx.data(), gy.data(), width);
+
+        const byte* row = lightness + size_t(y) * width;
+        const byte* visible = opaque.empty() ? nullptr : &opaque[size_t(y) * width];
+        char* out = &output[size_t(y) * (width + 1)];
+        for(int x = 0; x < width; x++) {
+            if(visible && !visible[x]) {
+                out[x] = ' ';
+                continue;
+            }
+            char edge = edge_glyph(gx[x], gy[x], threshold);
+            out[x] = edge ? edge : glyphs[row[x]];
+        }
+    }
+    return output;
+}
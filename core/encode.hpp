@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "png.hpp"
+#include "../stb/stb_image_write.h"
+
+enum class ImageFormat { AUTO, PNG, JPG, BMP, TGA };
+
+inline bool parse_image_format(const std::string& value, ImageFormat& format) {
+    std::string name = value;
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    if(name == "png") format = ImageFormat::PNG;
+    else if(name == "jpg" || name == "jpeg") format = ImageFormat::JPG;
+    else if(name == "bmp") format = ImageFormat::BMP;
+    else if(name == "tga") format = ImageFormat::TGA;
+    else if(name == "auto") format = ImageFormat::AUTO;
+    else return false;
+    return true;
+}
+
+// The extension decides; anything unrecognized is written as PNG.
+inline ImageFormat format_from_path(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    ImageFormat format = ImageFormat::PNG;
+    if(dot != std::string::npos && path.find_first_of("/\\", dot) == std::string::npos)
+        parse_image_format(path.substr(dot + 1), format);
+    return format == ImageFormat::AUTO ? ImageFormat::PNG : format;
+}
+
+inline const char* format_extension(ImageFormat format) {
+    switch(format) {
+        case ImageFormat::JPG: return ".jpg";
+        case ImageFormat::BMP: return ".bmp";
+        case ImageFormat::TGA: return ".tga";
+        default: return ".png";
+    }
+}
+
+struct EncodeOptions {
+    ImageFormat format = ImageFormat::AUTO;
+    int jpg_quality = 90;
+    PngOptions png;
+};
+
+// Collects encoder output in memory. clear() keeps the capacity, so one sink
+// can be reused for a whole batch of images.
+struct MemorySink {
+    std::vector<unsigned char> bytes;
+
+    void clear() { bytes.clear(); }
+
+    static void callback(void* context, void* data, int size) {
+        const unsigned char* begin = static_cast<const unsigned char*>(data);
+        std::vector<unsigned char>& bytes = static_cast<MemorySink*>(context)->bytes;
+        bytes.insert(bytes.end(), begin, begin + size);
+    }
+};
+
+// Collects encoder output and hands it to the file in large writes.
+struct FileSink {
+    FILE* file = nullptr;
+    std::vector<unsigned char> buffer;
+    bool ok = true;
+
+    explicit FileSink(FILE* file, size_t capacity = 1 << 16) : file(file) { buffer.reserve(capacity); }
+
+    void write(const void* data, size_t size) {
+        if(buffer.size() + size > buffer.capacity()) flush();
+        if(size >= buffer.capacity()) {
+            ok = fwrite(data, 1, size, file) == size && ok;
+            return;
+        }
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+
+    void flush() {
+        if(buffer.empty()) return;
+        ok = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size() && ok;
+        buffer.clear();
+    }
+
+    static void callback(void* context, void* data, int size) {
+        static_cast<FileSink*>(context)->write(data, size_t(size));
+    }
+};
+
+// Encodes width x height pixels of 1-4 interleaved channels into any
+// stb_image_write sink. AUTO means PNG here; paths resolve it by extension.
+inline bool encode_image(stbi_write_func* sink, void* context, int width, int height, int channels, const unsigned char* pixels, const EncodeOptions& options) {
+    switch(options.format) {
+        case ImageFormat::JPG:
+            return stbi_write_jpg_to_func(sink, context, width, height, channels, pixels, options.jpg_quality) != 0;
+        case ImageFormat::BMP:
+            return stbi_write_bmp_to_func(sink, context, width, height, channels, pixels) != 0;
+        case ImageFormat::TGA:
+            return stbi_write_tga_to_func(sink, context, width, height, channels, pixels) != 0;
+        default:
+            stbi_write_png_compression_level = options.png.level;
+            stbi_write_force_png_filter = options.png.filter;
+            png_deflate_strips() = options.png.strips;
+            return stbi_write_png_to_func(sink, context, width, height, channels, pixels, 0) != 0;
+    }
+}
+
+inline bool encode_image(MemorySink& sink, int width, int height, int channels, const unsigned char* pixels, const EncodeOptions& options) {
+    sink.clear();
+    return encode_image(MemorySink::callback, &sink, width, height, channels, pixels, options);
+}
+
+inline bool write_image(const std::string& path, int width, int height, int channels, const unsigned char* pixels, EncodeOptions options) {
+    if(options.format == ImageFormat::AUTO) options.format = format_from_path(path);
+    FILE* file = fopen(path.c_str(), "wb");
+    if(!file) return false;
+
+    FileSink sink(file);
+    bool ok = encode_image(FileSink::callback, &sink, width, height, channels, pixels, options);
+    sink.flush();
+    ok = sink.ok && ok;
+    return (fclose(file) == 0) && ok;
+}
+
+// Writes intermediate pipeline stages as <prefix>-<stage><ext> through one
+// reused buffer. Disabled while the prefix is empty.
+struct StageWriter {
+    std::string prefix;
+    EncodeOptions options;
+    MemorySink buffer;
+
+    bool enabled() const { return !prefix.empty(); }
+
+    bool write(const std::string& stage, int width, int height, int channels, const unsigned char* pixels) {
+        if(!enabled()) return true;
+        if(!encode_image(buffer, width, height, channels, pixels, options)) return false;
+
+        std::string path = prefix + "-" + stage + format_extension(options.format);
+        FILE* file = fopen(path.c_str(), "wb");
+        if(!file) return false;
+        bool ok = fwrite(buffer.bytes.data(), 1, buffer.bytes.size(), file) == buffer.bytes.size();
+        return (fclose(file) == 0) && ok;
+    }
+};
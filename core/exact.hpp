@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "image.hpp"
+#include "glyphs.hpp"
+#include "shape.hpp"
+#include "tone.hpp"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+// Exact-quality matching: every cell is resampled to an 8x16 tile and compared
+// against every glyph by sum of squared differences. Glyphs are normalized
+// like ShapeMatcher's (see build_atlas), so the two differ only in how finely
+// they sample a cell: 3x3 regions at 2 bits against 8x16 pixels at 8.
+constexpr int TILE_WIDTH = 8;
+constexpr int TILE_HEIGHT = 16;
+constexpr int TILE_SIZE = TILE_WIDTH * TILE_HEIGHT;
+
+struct alignas(64) Tile {
+    byte pixels[TILE_SIZE];
+};
+
+// Glyph tiles stored back to back, each on its own pair of cache lines.
+struct GlyphAtlas {
+    std::string glyphs;
+    std::vector<Tile> tiles;
+};
+
+// Area-averages a width x height region into a tile. Regions smaller than the
+// tile fall back to one source pixel per tile pixel.
+template <typename Sample>
+Tile resample_tile(int width, int height, Sample sample) {
+    Tile tile;
+    for(int ty = 0; ty < TILE_HEIGHT; ty++) {
+        int y0 = ty * height / TILE_HEIGHT, y1 = (ty + 1) * height / TILE_HEIGHT;
+        if(y1 <= y0) y1 = y0 + 1;
+        for(int tx = 0; tx < TILE_WIDTH; tx++) {
+            int x0 = tx * width / TILE_WIDTH, x1 = (tx + 1) * width / TILE_WIDTH;
+            if(x1 <= x0) x1 = x0 + 1;
+            uint32_t sum = 0;
+            for(int y = y0; y < y1; y++)
+                for(int x = x0; x < x1; x++) sum += sample(x, y);
+            tile.pixels[ty * TILE_WIDTH + tx] = static_cast<byte>(sum / ((x1 - x0) * (y1 - y0)));
+        }
+    }
+    return tile;
+}
+
+// Glyph ink is scaled the way ShapeMatcher scales its features: by the
+// densest of the 3x3 regions over the whole set, so that region reads as full
+// density. Glyphs never reach full coverage, and without this a dark cell
+// would be compared against ink no glyph has; with it both matchers measure
+// cells against the same glyph intensities.
+inline GlyphAtlas build_atlas(const GlyphSet& set) {
+    GlyphAtlas atlas;
+    atlas.glyphs = set.glyphs;
+    float densest = 0.0f;
+    for(size_t i = 0; i < set.glyphs.size(); i++)
+        for(float f : glyph_features(set, i)) densest = f > densest ? f : densest;
+    float scale = densest > 0.0f ? 1.0f / densest : 1.0f;
+
+    for(size_t i = 0; i < set.glyphs.size(); i++) {
+        const byte* cell = set.bitmap(i);
+        atlas.tiles.push_back(resample_tile(set.cell_width, set.cell_height, [&](int x, int y) {
+            float ink = cell[y * set.cell_width + x] * scale;
+            return ink < 255.0f ? static_cast<uint32_t>(ink + 0.5f) : 255u;
+        }));
+    }
+    return atlas;
+}
+
+// SSD of two tiles. The first half is summed before the second so a glyph
+// that is already worse than `limit` is rejected after 64 bytes.
+inline uint32_t tile_ssd(const Tile& a, const Tile& b, uint32_t limit) {
+#if defined(__AVX2__)
+    auto half = [&](int offset) {
+        __m256i acc = _mm256_setzero_si256();
+        for(int i = offset; i < offset + TILE_SIZE / 2; i += 16) {
+            __m256i x = _mm256_cvtepu8_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(a.pixels + i)));
+            __m256i y = _mm256_cvtepu8_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(b.pixels + i)));
+            __m256i d = _mm256_sub_epi16(x, y);
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(d, d));
+        }
+        __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+    };
+#elif defined(__SSE2__) || defined(_M_X64)
+    auto half = [&](int offset) {
+        __m128i zero = _mm_setzero_si128();
+        __m128i acc = _mm_setzero_si128();
+        for(int i = offset; i < offset + TILE_SIZE / 2; i += 16) {
+            __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(a.pixels + i));
+            __m128i y = _mm_load_si128(reinterpret_cast<const __m128i*>(b.pixels + i));
+            __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(x, zero), _mm_unpacklo_epi8(y, zero));
+            __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(x, zero), _mm_unpackhi_epi8(y, zero));
+            acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+        }
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(acc));
+    };
+#else
+    auto half = [&](int offset) {
+        uint32_t sum = 0;
+        for(int i = offset; i < offset + TILE_SIZE / 2; i++) {
+            int d = a.pixels[i] - b.pixels[i];
+            sum += d * d;
+        }
+        return sum;
+    };
+#endif
+    uint32_t sum = half(0);
+    if(sum >= limit) return sum;
+    return sum + half(TILE_SIZE / 2);
+}
+
+inline char exact_match(const GlyphAtlas& atlas, const Tile& tile) {
+    size_t best = 0;
+    uint32_t best_ssd = UINT32_MAX;
+    for(size_t i = 0; i < atlas.tiles.size(); i++) {
+        uint32_t ssd = tile_ssd(tile, atlas.tiles[i], best_ssd);
+        if(ssd < best_ssd) {
+            best_ssd = ssd;
+            best = i;
+        }
+    }
+    return atlas.glyphs.empty() ? ' ' : atlas.glyphs[best];
+}
+
+// Rows of cells are split into contiguous bands, one per thread, each writing
+// its own slice of the preallocated output.
+inline std::string exact_ascii_image(const byte* lightness, int width, int height, int cell, const GlyphAtlas& atlas, const ToneCurve& curve) {
+    int columns = width / cell, rows = height / cell;
+    if(columns <= 0 || rows <= 0) return "";
+    std::string output(size_t(columns + 1) * rows - 1, '\n');
+
+    auto render_rows = [&](int first, int last) {
+        for(int row = first; row < last; row++) {
+            char* out = &output[size_t(row) * (columns + 1)];
+            const byte* band = lightness + size_t(row) * cell * width;
+            for(int column = 0; column < columns; column++) {
+                const byte* block = band + column * cell;
+                Tile tile = resample_tile(cell, cell, [&](int x, int y) {
+                    return curve[block[size_t(y) * width + x]];
+                });
+                out[column] = exact_match(atlas, tile);
+            }
+        }
+    };
+
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    if(threads < 1) threads = 1;
+    if(threads > rows) threads = rows;
+    std::vector<std::thread> workers;
+    for(int t = 1; t < threads; t++)
+        workers.emplace_back(render_rows, t * rows / threads, (t + 1) * rows / threads);
+    render_rows(0, rows / threads);
+    for(std::thread& worker : workers)
+        worker.join();
+    return output;
+}
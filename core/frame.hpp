@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "cells.hpp"
+#include "image.hpp"
+
+// .asf frame: a fixed header followed by the glyph, fg and bg planes, each
+// columns x rows bytes without row separators. Planes flagged in rle_planes
+// are stored PackBits-compressed; raw planes are used in place, so a mapped
+// file replays without any decoding. Little-endian throughout.
+//
+// A color byte of FRAME_DEFAULT_COLOR leaves the cell in the console's own
+// foreground or background, resolved when the frame is shown. It is new in
+// version 2; version 1 frames only hold palette indices and read as is.
+#define FRAME_MAGIC "ASF1"
+constexpr uint16_t FRAME_VERSION = 2;
+constexpr byte FRAME_DEFAULT_COLOR = CELL_DEFAULT_COLOR;
+constexpr int FRAME_PLANES = 3;
+constexpr int FRAME_PALETTE = 16;
+
+struct FrameHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t rle_planes; // bit i: plane i is RLE encoded
+    uint32_t columns, rows;
+    uint32_t plane_sizes[FRAME_PLANES];
+    byte palette[FRAME_PALETTE * 3];
+};
+
+// Control byte n < 128: n + 1 literal bytes follow; n >= 128: the next byte
+// repeats n - 126 times.
+inline void rle_encode(const byte* data, size_t size, std::vector<byte>& out) {
+    size_t i = 0;
+    while(i < size) {
+        size_t run = 1;
+        while(i + run < size && run < 129 && data[i + run] == data[i]) run++;
+        if(run >= 2) {
+            out.push_back(static_cast<byte>(run + 126));
+            out.push_back(data[i]);
+            i += run;
+            continue;
+        }
+        size_t start = i, count = 0;
+        while(i < size && count < 128 && !(i + 1 < size && data[i + 1] == data[i])) {
+            i++;
+            count++;
+        }
+        out.push_back(static_cast<byte>(count - 1));
+        out.insert(out.end(), data + start, data + start + count);
+    }
+}
+
+inline bool rle_decode(const byte* data, size_t size, byte* out, size_t out_size) {
+    size_t o = 0;
+    for(size_t i = 0; i < size;) {
+        byte n = data[i++];
+        if(n < 128) {
+            size_t count = size_t(n) + 1;
+            if(i + count > size || o + count > out_size) return false;
+            memcpy(out + o, data + i, count);
+            i += count;
+            o += count;
+        } else {
+            size_t count = size_t(n) - 126;
+            if(i >= size || o + count > out_size) return false;
+            memset(out + o, data[i++], count);
+            o += count;
+        }
+    }
+    return o == out_size;
+}
+
+// A color plane with FRAME_DEFAULT_COLOR replaced by `color`.
+inline void resolve_default_color(const byte* plane, size_t cells, byte color, std::vector<byte>& out) {
+    out.resize(cells);
+    for(size_t i = 0; i < cells; i++) out[i] = plane[i] == FRAME_DEFAULT_COLOR ? color : plane[i];
+}
+
+// Planes are compressed only where that makes them smaller.
+inline void encode_frame(const char* glyphs, size_t stride, int columns, int rows, const byte* fg, const byte* bg, const RGBA* palette, bool rle, std::vector<byte>& out) {
+    size_t cells = size_t(columns) * rows;
+    std::vector<byte> planes[FRAME_PLANES];
+    planes[0].resize(cells);
+    for(int row = 0; row < rows; row++)
+        memcpy(planes[0].data() + size_t(row) * columns, glyphs + size_t(row) * stride, columns);
+    planes[1].assign(fg, fg + cells);
+    planes[2].assign(bg, bg + cells);
+
+    FrameHeader header = {};
+    memcpy(header.magic, FRAME_MAGIC, 4);
+    header.version = FRAME_VERSION;
+    header.columns = columns;
+    header.rows = rows;
+    for(int p = 0; p < FRAME_PALETTE; p++) {
+        header.palette[p * 3] = palette[p].r;
+        header.palette[p * 3 + 1] = palette[p].g;
+        header.palette[p * 3 + 2] = palette[p].b;
+    }
+    for(int p = 0; p < FRAME_PLANES; p++) {
+        if(rle) {
+            std::vector<byte> packed;
+            rle_encode(planes[p].data(), cells, packed);
+            if(packed.size() < cells) {
+                planes[p].swap(packed);
+                header.rle_planes |= 1 << p;
+            }
+        }
+        header.plane_sizes[p] = static_cast<uint32_t>(planes[p].size());
+    }
+
+    out.resize(sizeof(header));
+    memcpy(out.data(), &header, sizeof(header));
+    for(const std::vector<byte>& plane : planes) out.insert(out.end(), plane.begin(), plane.end());
+}
+
+// A frame over borrowed bytes. Raw planes point into the source buffer, which
+// must outlive the frame; RLE planes are decoded into the frame's own storage.
+struct Frame {
+    int columns = 0, rows = 0;
+    RGBA palette[FRAME_PALETTE];
+    const char* glyphs = nullptr;
+    const byte* fg = nullptr;
+    const byte* bg = nullptr;
+    std::vector<byte> storage;
+
+    Frame() = default;
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+
+    size_t cells() const { return size_t(columns) * rows; }
+
+    bool parse(const byte* data, size_t size) {
+        FrameHeader header;
+        if(!data || size < sizeof(header)) return false;
+        memcpy(&header, data, sizeof(header));
+        if(memcmp(header.magic, FRAME_MAGIC, 4) || header.version < 1 || header.version > FRAME_VERSION) return false;
+
+        // Nothing is allocated until the planes present could hold every
+        // cell: a raw plane stores exactly one byte per cell, and each
+        // two-byte PackBits run expands to at most 129.
+        if(header.columns > INT32_MAX || header.rows > INT32_MAX) return false;
+        uint64_t cell_count = uint64_t(header.columns) * header.rows, payload = 0;
+        if(cell_count > SIZE_MAX / FRAME_PLANES) return false;
+        for(int p = 0; p < FRAME_PLANES; p++) {
+            uint64_t length = header.plane_sizes[p];
+            payload += length;
+            uint64_t most = header.rle_planes & (1 << p) ? length / 2 * 129 : length;
+            if(cell_count > most) return false;
+        }
+        if(payload > size - sizeof(header)) return false;
+
+        columns = static_cast<int>(header.columns);
+        rows = static_cast<int>(header.rows);
+        for(int p = 0; p < FRAME_PALETTE; p++)
+            palette[p] = {header.palette[p * 3], header.palette[p * 3 + 1], header.palette[p * 3 + 2]};
+
+        size_t offset = sizeof(header), decoded = 0;
+        for(int p = 0; p < FRAME_PLANES; p++)
+            if(header.rle_planes & (1 << p)) decoded += cells();
+        storage.resize(decoded);
+
+        const byte* planes[FRAME_PLANES];
+        byte* target = storage.data();
+        for(int p = 0; p < FRAME_PLANES; p++) {
+            size_t length = header.plane_sizes[p];
+            if(offset + length > size) return false;
+            if(header.rle_planes & (1 << p)) {
+                if(!rle_decode(data + offset, length, target, cells())) return false;
+                planes[p] = target;
+                target += cells();
+            } else {
+                if(length != cells()) return false;
+                planes[p] = data + offset;
+            }
+            offset += length;
+        }
+        // Colors index the 16-entry palette wherever the frame is drawn, so
+        // anything else is corruption; the default marker is new in version 2.
+        for(int p = 1; p < FRAME_PLANES; p++)
+            for(size_t i = 0; i < cells(); i++) {
+                byte color = planes[p][i];
+                if(color >= FRAME_PALETTE && (color != FRAME_DEFAULT_COLOR || header.version < 2)) return false;
+            }
+        glyphs = reinterpret_cast<const char*>(planes[0]);
+        fg = planes[1];
+        bg = planes[2];
+        return true;
+    }
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "image.hpp"
+#include "cache.hpp"
+#include "../stb/stb_truetype.h"
+
+#define PRINTABLE_ASCII " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~"
+
+typedef std::array<char, 256> GlyphRamp;
+
+// Coverage bitmaps of candidate glyphs, each rendered into a full character
+// cell (advance width x line height) so glyphs are comparable to each other.
+struct GlyphSet {
+    int cell_width = 0, cell_height = 0;
+    std::string glyphs;
+    std::vector<byte> bitmaps;
+
+    size_t cell_size() const { return size_t(cell_width) * cell_height; }
+    const byte* bitmap(size_t i) const { return bitmaps.data() + i * cell_size(); }
+
+    float coverage(size_t i) const {
+        const byte* cell = bitmap(i);
+        uint32_t sum = 0;
+        for(size_t p = 0; p < cell_size(); p++) sum += cell[p];
+        return sum / (255.0f * cell_size());
+    }
+};
+
+inline bool rasterize_glyphs(const std::vector<unsigned char>& font_data, float pixel_height, const std::string& candidates, GlyphSet& set) {
+    stbtt_fontinfo font;
+    if(font_data.empty() || !stbtt_InitFont(&font, font_data.data(), stbtt_GetFontOffsetForIndex(font_data.data(), 0)))
+        return false;
+
+    float scale = stbtt_ScaleForPixelHeight(&font, pixel_height);
+    int ascent, descent, line_gap, advance, lsb;
+    stbtt_GetFontVMetrics(&font, &ascent, &descent, &line_gap);
+    stbtt_GetCodepointHMetrics(&font, 'M', &advance, &lsb);
+
+    set.cell_width = std::max(1, static_cast<int>(advance * scale + 0.5f));
+    set.cell_height = std::max(1, static_cast<int>((ascent - descent) * scale + 0.5f));
+    set.glyphs = candidates;
+    set.bitmaps.assign(candidates.size() * set.cell_size(), 0);
+
+    int baseline = static_cast<int>(ascent * scale + 0.5f);
+    for(size_t i = 0; i < candidates.size(); i++) {
+        int codepoint = static_cast<unsigned char>(candidates[i]);
+        int x0, y0, x1, y1;
+        stbtt_GetCodepointBitmapBox(&font, codepoint, scale, scale, &x0, &y0, &x1, &y1);
+        int x = std::max(0, x0), y = std::max(0, baseline + y0);
+        int w = std::min(x1 - x0, set.cell_width - x), h = std::min(y1 - y0, set.cell_height - y);
+        if(w <= 0 || h <= 0) continue;
+
+        byte* cell = set.bitmaps.data() + i * set.cell_size();
+        stbtt_MakeCodepointBitmap(&font, cell + y * set.cell_width + x, w, h, set.cell_width, scale, scale, codepoint);
+    }
+    return true;
+}
+
+inline bool load_glyph_set(const std::string& font_path, float pixel_height, const std::string& candidates, GlyphSet& set) {
+    std::vector<unsigned char> font_data;
+    return read_file(font_path, font_data) && rasterize_glyphs(font_data, pixel_height, candidates, set);
+}
+
+// Orders candidates by measured ink and spreads them over 256 density steps:
+// entry d holds the glyph whose normalized coverage is closest to d / 255.
+inline GlyphRamp density_ramp(const GlyphSet& set) {
+    std::vector<float> coverage(set.glyphs.size());
+    float lo = 1.0f, hi = 0.0f;
+    for(size_t i = 0; i < set.glyphs.size(); i++) {
+        coverage[i] = set.coverage(i);
+        lo = std::min(lo, coverage[i]);
+        hi = std::max(hi, coverage[i]);
+    }
+
+    GlyphRamp ramp;
+    ramp.fill(set.glyphs.empty() ? ' ' : set.glyphs[0]);
+    if(set.glyphs.empty()) return ramp;
+
+    float range = hi > lo ? hi - lo : 1.0f;
+    for(size_t d = 0; d < 256; d++) {
+        float target = d / 255.0f;
+        size_t best = 0;
+        float best_error = 2.0f;
+        for(size_t i = 0; i < coverage.size(); i++) {
+            float error = std::abs((coverage[i] - lo) / range - target);
+            if(error < best_error) {
+                best_error = error;
+                best = i;
+            }
+        }
+        ramp[d] = set.glyphs[best];
+    }
+    return ramp;
+}
+
+// Font calibration is cached on disk under a key of the font bytes, pixel
+// height and candidate set, so it only runs once per font configuration.
+inline bool calibrated_ramp(const std::string& font_path, float pixel_height, const std::string& candidates, GlyphRamp& ramp) {
+    std::vector<unsigned char> font_data;
+    if(!read_file(font_path, font_data)) return false;
+
+    uint64_t key = fnv1a64(font_data.data(), font_data.size());
+    key = fnv1a64(&pixel_height, sizeof(pixel_height), key);
+    key = fnv1a64(candidates.data(), candidates.size(), key);
+    std::string path = cache_path("asciimage-ramp-" + hex64(key) + ".bin");
+
+    std::vector<unsigned char> cached;
+    if(read_file(path, cached) && cached.size() == ramp.size()) {
+        std::copy(cached.begin(), cached.end(), ramp.begin());
+        return true;
+    }
+
+    GlyphSet set;
+    if(!rasterize_glyphs(font_data, pixel_height, candidates, set)) return false;
+    ramp = density_ramp(set);
+    write_file_atomic(path, ramp.data(), ramp.size());
+    return true;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "image.hpp"
+
+// High-precision input (.hdr floats, 16-bit PNG/PNM) is tone mapped into the
+// regular 8-bit buffer instead of being clamped or truncated by stbi_load.
+enum class ToneMap {
+    AUTO, NONE, REINHARD, ACES
+};
+
+struct HdrOptions {
+    ToneMap tonemap = ToneMap::AUTO; // Reinhard for float input, none for 16-bit
+    float exposure = 0.0f; // 0 = auto (scene key of 0.18)
+};
+
+inline bool parse_tonemap(const std::string& name, ToneMap& tonemap) {
+    if(name == "auto") tonemap = ToneMap::AUTO;
+    else if(name == "none") tonemap = ToneMap::NONE;
+    else if(name == "reinhard") tonemap = ToneMap::REINHARD;
+    else if(name == "aces") tonemap = ToneMap::ACES;
+    else return false;
+    return true;
+}
+
+inline bool parse_exposure(const std::string& value, float& exposure) {
+    char* end = nullptr;
+    exposure = std::strtof(value.c_str(), &end);
+    return end && !*end && exposure > 0.0f;
+}
+
+inline bool is_high_precision(const std::string& path) {
+    return stbi_is_hdr(path.c_str()) || stbi_is_16_bit(path.c_str());
+}
+
+constexpr size_t SRGB_ENCODE_SIZE = 1 << 13;
+
+// Linear [0, 1] -> sRGB byte, sampled finely enough that dark tones keep every code value.
+inline const byte* linear_to_srgb_table() {
+    struct Table {
+        byte values[SRGB_ENCODE_SIZE];
+
+        Table() {
+            for(size_t i = 0; i < SRGB_ENCODE_SIZE; i++) {
+                float c = i / float(SRGB_ENCODE_SIZE - 1);
+                float s = (c <= 0.0031308f) ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+                values[i] = static_cast<byte>(s * 255.0f + 0.5f);
+            }
+        }
+    };
+    static const Table table;
+    return table.values;
+}
+
+// 16-bit sRGB code value -> linear light.
+inline const float* srgb16_to_linear_table() {
+    struct Table {
+        std::vector<float> values;
+
+        Table() : values(65536) {
+            for(size_t i = 0; i < 65536; i++) {
+                float c = i / 65535.0f;
+                values[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+        }
+    };
+    static const Table table;
+    return table.values.data();
+}
+
+// Exposure that maps the log-average luminance of a pixel sample to 0.18.
+inline float auto_exposure(const float* linear, size_t pixels, int channels) {
+    size_t step = pixels > 4096 ? pixels / 4096 : 1;
+    double log_sum = 0.0;
+    size_t samples = 0;
+    for(size_t i = 0; i < pixels; i += step) {
+        const float* p = linear + i * channels;
+        float luminance = 0.2126f * p[0] + 0.7152f * p[1] + 0.0722f * p[2];
+        log_sum += std::log(1e-4 + (luminance > 0.0f ? luminance : 0.0f));
+        samples++;
+    }
+    float average = static_cast<float>(std::exp(log_sum / (samples ? samples : 1)));
+    return 0.18f / average;
+}
+
+// Applies exposure and the operator to a block of linear values in place.
+// Plain loops over a small contiguous buffer so the compiler can vectorise them.
+inline void tonemap_block(float* values, size_t count, ToneMap tonemap, float exposure) {
+    for(size_t i = 0; i < count; i++)
+        values[i] *= exposure;
+
+    switch(tonemap) {
+        case ToneMap::REINHARD:
+            for(size_t i = 0; i < count; i++)
+                values[i] = values[i] / (1.0f + values[i]);
+            break;
+        case ToneMap::ACES: // Narkowicz's fit of the ACES filmic curve
+            for(size_t i = 0; i < count; i++) {
+                float x = values[i];
+                values[i] = (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f);
+            }
+            break;
+        default:
+            break;
+    }
+
+    for(size_t i = 0; i < count; i++)
+        values[i] = values[i] < 0.0f ? 0.0f : (values[i] > 1.0f ? 1.0f : values[i]);
+}
+
+// Loads float or 16-bit data and writes the tone mapped 8-bit result over the
+// start of the same allocation, so the buffer is still freed by stbi_image_free.
+inline bool read_high_precision(Image& image, const HdrOptions& options) {
+    int width, height, bpp, channels = image.channels;
+    bool hdr = stbi_is_hdr(image.path.c_str());
+
+    void* raw = hdr ? static_cast<void*>(stbi_loadf(image.path.c_str(), &width, &height, &bpp, channels))
+                    : static_cast<void*>(stbi_load_16(image.path.c_str(), &width, &height, &bpp, channels));
+    if(!raw) return false;
+
+    size_t pixels = size_t(width) * height;
+    float* linear = static_cast<float*>(raw);
+    uint16_t* words = static_cast<uint16_t*>(raw);
+    byte* out = static_cast<byte*>(raw);
+    const float* decode16 = hdr ? nullptr : srgb16_to_linear_table();
+    const byte* encode = linear_to_srgb_table();
+
+    ToneMap tonemap = options.tonemap;
+    if(tonemap == ToneMap::AUTO)
+        tonemap = hdr ? ToneMap::REINHARD : ToneMap::NONE;
+
+    float exposure = options.exposure;
+    if(exposure <= 0.0f)
+        exposure = (hdr && tonemap != ToneMap::NONE) ? auto_exposure(linear, pixels, channels) : 1.0f;
+
+    // Whole pixels per block so the alpha channel lines up; the read of value i
+    // always happens before output byte i (<= its source offset) is written.
+    constexpr size_t BLOCK_PIXELS = 256;
+    float block[BLOCK_PIXELS * 4];
+    float alpha[BLOCK_PIXELS];
+    for(size_t first = 0; first < pixels; first += BLOCK_PIXELS) {
+        size_t count = (pixels - first < BLOCK_PIXELS) ? pixels - first : BLOCK_PIXELS;
+        size_t base = first * channels;
+        size_t colors = 0;
+        for(size_t p = 0; p < count; p++) {
+            for(int c = 0; c < 3; c++) {
+                size_t v = base + p * channels + c;
+                block[colors++] = hdr ? linear[v] : decode16[words[v]];
+            }
+            if(channels == 4) {
+                size_t v = base + p * channels + 3;
+                alpha[p] = hdr ? linear[v] : words[v] / 65535.0f;
+            }
+        }
+
+        tonemap_block(block, colors, tonemap, exposure);
+
+        for(size_t p = 0, k = 0; p < count; p++) {
+            byte* dst = out + base + p * channels;
+            for(int c = 0; c < 3; c++)
+                dst[c] = encode[static_cast<size_t>(block[k++] * (SRGB_ENCODE_SIZE - 1) + 0.5f)];
+            if(channels == 4) {
+                float a = alpha[p] < 0.0f ? 0.0f : (alpha[p] > 1.0f ? 1.0f : alpha[p]);
+                dst[3] = static_cast<byte>(a * 255.0f + 0.5f);
+            }
+        }
+    }
+
+    image.release();
+    image.data = out;
+    image.width = width;
+    image.height = height;
+    image.bpp = bpp;
+    return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include "../stb/stb_image.h"
+
+typedef unsigned char byte;
+
+struct RGBA {
+    byte r, g, b, a = 255;
+
+    byte max_value() const { return (r > g ? (r > b ? r : b) : (g > b ? g : b)); }
+    byte min_value() const { return (r < g ? (r < b ? r : b) : (g < b ? g : b)); }
+    float average() const { return (r + g + b) / 3.0f; }
+};
+
+// Owns the decoded pixels; move-only, so a buffer is freed exactly once. The
+// pixels come from stb_image and so from the current ImageAllocator.
+struct Image {
+    std::string path;
+    int width = 0, height = 0, bpp = 0, channels = 3;
+    byte* data = nullptr;
+
+    Image() = default;
+    Image(std::string path, int channels = 3) : path(path), channels(channels) {}
+
+    Image(const Image&) = delete;
+    Image& operator=(const Image&) = delete;
+
+    Image(Image&& other) noexcept { *this = std::move(other); }
+
+    Image& operator=(Image&& other) noexcept {
+        if(this != &other) {
+            release();
+            path = std::move(other.path);
+            width = other.width;
+            height = other.height;
+            bpp = other.bpp;
+            channels = other.channels;
+            data = other.data;
+            other.data = nullptr;
+        }
+        return *this;
+    }
+
+    size_t size() const { return size_t(width) * height * channels; }
+    size_t image_size() const { return size_t(width) * height; }
+
+    bool read(std::string rpath = "", int rchannels = 0) {
+        if(rchannels < 3 || rchannels > 4) rchannels = channels;
+        if(rpath.empty()) rpath = path;
+        release();
+
+        data = stbi_load(rpath.c_str(), &width, &height, &bpp, rchannels);
+        if(!data) return false;
+
+        channels = rchannels;
+        return true;
+    }
+
+    void release() {
+        if(data) stbi_image_free(data);
+        data = nullptr;
+    }
+
+    ~Image() { release(); }
+};
+
+inline float map(float input, float x1, float x2, float y1, float y2) {
+    return y1 + (input - x1) * (y2 - y1) / (x2 - x1);
+}
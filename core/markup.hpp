@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include "image.hpp"
+#include "../stb/stb_image_write.h"
+
+// HTML and SVG exporters for colored cell grids. Glyphs, fg and bg follow
+// rasterize_cells: `stride` bytes per glyph row, one palette index per cell.
+// Each row is built in one reused buffer and handed to the sink as soon as it
+// is complete; adjacent cells with the same colors share one element.
+
+inline void append_hex_color(std::string& out, const RGBA& c) {
+    const char* digits = "0123456789abcdef";
+    const byte channels[3] = {c.r, c.g, c.b};
+    out += '#';
+    for(byte v : channels) {
+        out += digits[v >> 4];
+        out += digits[v & 15];
+    }
+}
+
+inline void append_escaped(std::string& out, char ch) {
+    switch(ch) {
+        case '<': out += "&lt;"; break;
+        case '>': out += "&gt;"; break;
+        case '&': out += "&amp;"; break;
+        default: out += ch;
+    }
+}
+
+inline void flush_markup(std::string& out, stbi_write_func* sink, void* context) {
+    if(!out.empty()) sink(context, &out[0], static_cast<int>(out.size()));
+    out.clear();
+}
+
+// One class per palette entry and role: .f<i> colors the glyph, .b<i> the
+// cell background.
+inline void append_palette_classes(std::string& out, const RGBA* palette, size_t count, bool svg) {
+    for(size_t i = 0; i < count; i++) {
+        out += ".f" + std::to_string(i) + (svg ? "{fill:" : "{color:");
+        append_hex_color(out, palette[i]);
+        out += "}\n.b" + std::to_string(i) + (svg ? "{fill:" : "{background:");
+        append_hex_color(out, palette[i]);
+        out += "}\n";
+    }
+}
+
+inline void export_html(const char* glyphs, size_t stride, int columns, int rows, const byte* fg, const byte* bg, const RGBA* palette, size_t palette_size, stbi_write_func* sink, void* context) {
+    std::string out;
+    out.reserve(size_t(columns) * 24);
+    out += "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n<style>\n";
+    out += "pre.asciimage{font-family:monospace;line-height:1;margin:0}\n";
+    append_palette_classes(out, palette, palette_size, false);
+    out += "</style>\n</head>\n<body>\n<pre class=\"asciimage\">";
+    flush_markup(out, sink, context);
+
+    for(int row = 0; row < rows; row++) {
+        const char* text = glyphs + size_t(row) * stride;
+        const byte* f = fg + size_t(row) * columns;
+        const byte* b = bg + size_t(row) * columns;
+        for(int start = 0, end; start < columns; start = end) {
+            for(end = start + 1; end < columns && f[end] == f[start] && b[end] == b[start]; end++) {}
+            out += "<span class=\"f" + std::to_string(f[start]) + " b" + std::to_string(b[start]) + "\">";
+            for(int x = start; x < end; x++) append_escaped(out, text[x]);
+            out += "</span>";
+        }
+        out += '\n';
+        flush_markup(out, sink, context);
+    }
+    out += "</pre>\n</body>\n</html>\n";
+    flush_markup(out, sink, context);
+}
+
+// Backgrounds are one rect per run; glyphs one <text> per run, stretched to
+// the run width so the grid lines up whatever monospace font is available.
+inline void export_svg(const char* glyphs, size_t stride, int columns, int rows, const byte* fg, const byte* bg, const RGBA* palette, size_t palette_size, stbi_write_func* sink, void* context) {
+    const int cw = 8, ch = 16;
+    std::string out;
+    out.reserve(size_t(columns) * 48);
+    out += "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" + std::to_string(columns * cw) + "\" height=\"" + std::to_string(rows * ch) + "\">\n<style>\n";
+    out += "text{font-family:monospace;font-size:" + std::to_string(ch - 2) + "px;white-space:pre}\n";
+    append_palette_classes(out, palette, palette_size, true);
+    out += "</style>\n";
+    flush_markup(out, sink, context);
+
+    for(int row = 0; row < rows; row++) {
+        const char* text = glyphs + size_t(row) * stride;
+        const byte* f = fg + size_t(row) * columns;
+        const byte* b = bg + size_t(row) * columns;
+        std::string y = std::to_string(row * ch);
+        for(int start = 0, end; start < columns; start = end) {
+            for(end = start + 1; end < columns && b[end] == b[start]; end++) {}
+            out += "<rect class=\"b" + std::to_string(b[start]) + "\" x=\"" + std::to_string(start * cw) + "\" y=\"" + y +
+                   "\" width=\"" + std::to_string((end - start) * cw) + "\" height=\"" + std::to_string(ch) + "\"/>";
+        }
+
+        std::string baseline = std::to_string(row * ch + ch - 4);
+        for(int start = 0, end; start < columns; start = end) {
+            for(end = start + 1; end < columns && f[end] == f[start]; end++) {}
+            int first = start, last = end;
+            while(first < last && text[first] == ' ') first++;
+            while(last > first && text[last - 1] == ' ') last--;
+            if(first == last) continue;
+            out += "<text class=\"f" + std::to_string(f[start]) + "\" x=\"" + std::to_string(first * cw) + "\" y=\"" + baseline +
+                   "\" textLength=\"" + std::to_string((last - first) * cw) + "\" lengthAdjust=\"spacingAndGlyphs\">";
+            for(int x = first; x < last; x++) append_escaped(out, text[x]);
+            out += "</text>";
+        }
+        out += '\n';
+        flush_markup(out, sink, context);
+    }
+    out += "</svg>\n";
+    flush_markup(out, sink, context);
+}
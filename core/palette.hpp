@@ -0,0 +1,269 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+#include "image.hpp"
+#include "color_space.hpp"
+#include "planes.hpp"
+
+// Colors are quantized to 5 bits per channel (32768 bins) for both the
+// histogram and the pixel -> palette lookup table.
+constexpr size_t PALETTE_BINS = 1 << 15;
+constexpr size_t PALETTE_MAX = 256;
+
+inline uint16_t rgb555(byte r, byte g, byte b) {
+    return static_cast<uint16_t>(((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3));
+}
+
+inline RGBA rgb555_color(uint16_t bin) {
+    byte r = (bin >> 10) & 0x1F, g = (bin >> 5) & 0x1F, b = bin & 0x1F;
+    return {static_cast<byte>((r << 3) | (r >> 2)), static_cast<byte>((g << 3) | (g >> 2)), static_cast<byte>((b << 3) | (b >> 2))};
+}
+
+struct PaletteBin {
+    uint16_t bin;
+    uint32_t count;
+};
+
+struct Palette {
+    std::vector<RGBA> entries;
+
+    size_t size() const { return entries.size(); }
+    const RGBA& operator[](size_t i) const { return entries[i]; }
+};
+
+// Non-empty bins of a 5:5:5 histogram built from at most `sample_limit` pixels,
+// leaving out those a `mask` (one byte per pixel, rows unpadded) marks zero.
+inline std::vector<PaletteBin> palette_histogram(const PixelPlanes& planes, const byte* mask = nullptr, size_t sample_limit = 1 << 16) {
+    std::vector<uint32_t> histogram(PALETTE_BINS, 0);
+    size_t count = planes.pixel_count();
+    size_t step = (sample_limit && count > sample_limit) ? count / sample_limit : 1;
+    for(size_t i = 0; i < count; i += step) {
+        if(mask && !mask[i]) continue;
+        int y = static_cast<int>(i / planes.width), x = static_cast<int>(i % planes.width);
+        histogram[rgb555(planes.row(CHANNEL_R, y)[x], planes.row(CHANNEL_G, y)[x], planes.row(CHANNEL_B, y)[x])]++;
+    }
+
+    std::vector<PaletteBin> bins;
+    for(size_t i = 0; i < PALETTE_BINS; i++)
+        if(histogram[i]) bins.push_back({static_cast<uint16_t>(i), histogram[i]});
+    return bins;
+}
+
+inline int bin_channel(uint16_t bin, int axis) {
+    return (bin >> (10 - axis * 5)) & 0x1F;
+}
+
+// Median cut: repeatedly split the most populated box along its longest
+// axis at the weighted median until `max_colors` boxes exist.
+inline Palette median_cut(std::vector<PaletteBin> bins, size_t max_colors) {
+    struct Box {
+        size_t begin = 0, end = 0;
+        uint64_t count = 0;
+        int axis = 0, range = 0;
+    };
+
+    auto measure = [&bins](Box& box) {
+        int lo[3] = {31, 31, 31}, hi[3] = {0, 0, 0};
+        box.count = 0;
+        for(size_t i = box.begin; i < box.end; i++) {
+            for(int c = 0; c < 3; c++) {
+                int v = bin_channel(bins[i].bin, c);
+                lo[c] = std::min(lo[c], v);
+                hi[c] = std::max(hi[c], v);
+            }
+            box.count += bins[i].count;
+        }
+        box.axis = 0;
+        for(int c = 1; c < 3; c++)
+            if(hi[c] - lo[c] > hi[box.axis] - lo[box.axis]) box.axis = c;
+        box.range = hi[box.axis] - lo[box.axis];
+    };
+
+    Palette palette;
+    if(bins.empty() || max_colors == 0) return palette;
+    max_colors = std::min(max_colors, PALETTE_MAX);
+
+    std::vector<Box> boxes;
+    boxes.push_back({0, bins.size()});
+    measure(boxes.back());
+
+    while(boxes.size() < max_colors) {
+        Box* target = nullptr;
+        for(Box& box : boxes)
+            if(box.range > 0 && (!target || box.count > target->count)) target = &box;
+        if(!target) break;
+
+        // Weighted median along the axis from a 32-bucket count, then an O(n) partition.
+        int axis = target->axis;
+        uint64_t axis_counts[32] = {};
+        for(size_t i = target->begin; i < target->end; i++)
+            axis_counts[bin_channel(bins[i].bin, axis)] += bins[i].count;
+
+        int lo = 0, hi = 31;
+        while(!axis_counts[lo]) lo++;
+        while(!axis_counts[hi]) hi--;
+        uint64_t half = target->count / 2, acc = 0;
+        int median = lo;
+        while(median < hi - 1 && acc + axis_counts[median] <= half)
+            acc += axis_counts[median++];
+
+        auto middle = std::partition(bins.begin() + target->begin, bins.begin() + target->end, [axis, median](const PaletteBin& bin) {
+            return bin_channel(bin.bin, axis) <= median;
+        });
+        size_t split = middle - bins.begin();
+
+        Box upper = {split, target->end};
+        target->end = split;
+        measure(*target);
+        measure(upper);
+        boxes.push_back(upper);
+    }
+
+    for(const Box& box : boxes) {
+        uint64_t r = 0, g = 0, b = 0;
+        for(size_t i = box.begin; i < box.end; i++) {
+            RGBA c = rgb555_color(bins[i].bin);
+            r += c.r * uint64_t(bins[i].count);
+            g += c.g * uint64_t(bins[i].count);
+            b += c.b * uint64_t(bins[i].count);
+        }
+        palette.entries.push_back({static_cast<byte>(r / box.count), static_cast<byte>(g / box.count), static_cast<byte>(b / box.count)});
+    }
+    return palette;
+}
+
+// Oklab of every 5:5:5 bin, computed once per process.
+inline const Oklab* rgb555_oklab_table() {
+    struct Table {
+        std::vector<Oklab> values;
+
+        Table() : values(PALETTE_BINS) {
+            std::vector<RGBA> colors(PALETTE_BINS);
+            std::vector<float> L(PALETTE_BINS), A(PALETTE_BINS), B(PALETTE_BINS);
+            for(size_t bin = 0; bin < PALETTE_BINS; bin++)
+                colors[bin] = rgb555_color(static_cast<uint16_t>(bin));
+            srgb_to_oklab_planes(colors.data(), PALETTE_BINS, L.data(), A.data(), B.data());
+            for(size_t bin = 0; bin < PALETTE_BINS; bin++)
+                values[bin] = {L[bin], A[bin], B[bin]};
+        }
+    };
+    static const Table table;
+    return table.values.data();
+}
+
+// Nearest palette entry in Oklab, scanned over planar, padded arrays (four
+// entries per SSE2 step). Palettes are at most PALETTE_MAX entries and in
+// practice CONSOLE_COLORS, well below where a tree would pay off.
+class PaletteMatcher {
+public:
+    explicit PaletteMatcher(const Palette& palette);
+
+    size_t nearest(const Oklab& color) const;
+
+private:
+    size_t count = 0;
+    std::vector<float> L, A, B;
+};
+
+inline PaletteMatcher::PaletteMatcher(const Palette& palette) : count(palette.size()) {
+    size_t padded = (count + 3) & ~size_t(3);
+    L.assign(padded, 1e9f);
+    A.assign(padded, 1e9f);
+    B.assign(padded, 1e9f);
+    srgb_to_oklab_planes(palette.entries.data(), count, L.data(), A.data(), B.data());
+}
+
+inline size_t PaletteMatcher::nearest(const Oklab& color) const {
+    size_t best = 0;
+    size_t i = 0;
+#ifdef ASCIIMAGE_SSE2
+    __m128 qL = _mm_set1_ps(color.L), qA = _mm_set1_ps(color.a), qB = _mm_set1_ps(color.b);
+    __m128 best_d = _mm_set1_ps(1e30f);
+    __m128i best_i = _mm_setzero_si128();
+    __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+    for(; i < L.size(); i += 4) {
+        __m128 dL = _mm_sub_ps(_mm_loadu_ps(&L[i]), qL);
+        __m128 dA = _mm_sub_ps(_mm_loadu_ps(&A[i]), qA);
+        __m128 dB = _mm_sub_ps(_mm_loadu_ps(&B[i]), qB);
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dL, dL), _mm_mul_ps(dA, dA)), _mm_mul_ps(dB, dB));
+        __m128 closer = _mm_cmplt_ps(d, best_d);
+        best_d = _mm_min_ps(d, best_d);
+        __m128i index = _mm_add_epi32(lanes, _mm_set1_epi32(static_cast<int>(i)));
+        best_i = _mm_or_si128(_mm_and_si128(_mm_castps_si128(closer), index), _mm_andnot_si128(_mm_castps_si128(closer), best_i));
+    }
+    alignas(16) float distances[4];
+    alignas(16) int32_t indices[4];
+    _mm_store_ps(distances, best_d);
+    _mm_store_si128(reinterpret_cast<__m128i*>(indices), best_i);
+    float best_distance = distances[0];
+    best = indices[0];
+    for(int lane = 1; lane < 4; lane++) {
+        if(distances[lane] < best_distance || (distances[lane] == best_distance && indices[lane] < static_cast<int32_t>(best))) {
+            best_distance = distances[lane];
+            best = indices[lane];
+        }
+    }
+#else
+    float best_distance = 1e30f;
+    for(; i < count; i++) {
+        float d = oklab_distance({L[i], A[i], B[i]}, color);
+        if(d < best_distance) {
+            best_distance = d;
+            best = i;
+        }
+    }
+#endif
+    return best;
+}
+
+// Lloyd iterations over the histogram bins, seeded by the median cut result.
+inline void kmeans_refine(Palette& palette, const std::vector<PaletteBin>& bins, int iterations) {
+    const Oklab* lab = rgb555_oklab_table();
+    std::vector<uint64_t> sums(palette.size() * 4);
+    for(int it = 0; it < iterations; it++) {
+        PaletteMatcher matcher(palette);
+        std::fill(sums.begin(), sums.end(), 0);
+        for(const PaletteBin& bin : bins) {
+            RGBA c = rgb555_color(bin.bin);
+            uint64_t* sum = &sums[matcher.nearest(lab[bin.bin]) * 4];
+            sum[0] += c.r * uint64_t(bin.count);
+            sum[1] += c.g * uint64_t(bin.count);
+            sum[2] += c.b * uint64_t(bin.count);
+            sum[3] += bin.count;
+        }
+        for(size_t i = 0; i < palette.size(); i++) {
+            const uint64_t* sum = &sums[i * 4];
+            if(!sum[3]) continue;
+            palette.entries[i] = {static_cast<byte>(sum[0] / sum[3]), static_cast<byte>(sum[1] / sum[3]), static_cast<byte>(sum[2] / sum[3])};
+        }
+    }
+}
+
+inline Palette adaptive_palette(const PixelPlanes& planes, size_t max_colors, const byte* mask = nullptr, int kmeans_iterations = 2) {
+    std::vector<PaletteBin> bins = palette_histogram(planes, mask);
+    Palette palette = median_cut(bins, max_colors);
+    kmeans_refine(palette, bins, kmeans_iterations);
+    return palette;
+}
+
+// Precomputed 5:5:5 color -> palette index table, matched in Oklab.
+struct PaletteLUT {
+    std::vector<byte> index;
+
+    void build(const Palette& palette) {
+        index.assign(PALETTE_BINS, 0);
+        if(!palette.size()) return;
+        const Oklab* lab = rgb555_oklab_table();
+        PaletteMatcher matcher(palette);
+        for(size_t bin = 0; bin < PALETTE_BINS; bin++)
+            index[bin] = static_cast<byte>(matcher.nearest(lab[bin]));
+    }
+
+    byte lookup(const RGBA& color) const { return index[rgb555(color.r, color.g, color.b)]; }
+
+    void lookup_row(const byte* r, const byte* g, const byte* b, byte* out, int width) const {
+        for(int x = 0; x < width; x++) out[x] = index[rgb555(r[x], g[x], b[x])];
+    }
+};
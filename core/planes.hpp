@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include "image.hpp"
+
+#if defined(__SSSE3__)
+    #include <tmmintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+// Every plane row starts on its own cache line.
+constexpr size_t PLANE_ALIGN = 64;
+
+enum Channel {
+    CHANNEL_R, CHANNEL_G, CHANNEL_B, CHANNEL_A, CHANNEL_L,
+    PLANE_COUNT
+};
+
+// A width x height window into one plane.
+struct PlaneView {
+    byte* data = nullptr;
+    int width = 0, height = 0;
+    size_t stride = 0;
+
+    byte* row(int y) const { return data + size_t(y) * stride; }
+    PlaneView tile(int x, int y, int w, int h) const { return {row(y) + x, w, h, stride}; }
+};
+
+struct AlignedDelete {
+    void operator()(byte* p) const { ::operator delete(p, std::align_val_t(PLANE_ALIGN)); }
+};
+
+// Floor of (max + min) / 2 per pixel, as lightness(RGBA), 16 pixels a step.
+// Rows must be 16-byte aligned, as PixelPlanes rows are.
+inline void lightness_row(const byte* r, const byte* g, const byte* b, byte* out, int width) {
+    int x = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i one = _mm_set1_epi8(1);
+    for(; x + 16 <= width; x += 16) {
+        __m128i vr = _mm_load_si128(reinterpret_cast<const __m128i*>(r + x));
+        __m128i vg = _mm_load_si128(reinterpret_cast<const __m128i*>(g + x));
+        __m128i vb = _mm_load_si128(reinterpret_cast<const __m128i*>(b + x));
+        __m128i hi = _mm_max_epu8(_mm_max_epu8(vr, vg), vb);
+        __m128i lo = _mm_min_epu8(_mm_min_epu8(vr, vg), vb);
+        __m128i avg = _mm_sub_epi8(_mm_avg_epu8(hi, lo), _mm_and_si128(_mm_xor_si128(hi, lo), one));
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + x), avg);
+    }
+#endif
+    for(; x < width; x++) {
+        byte hi = r[x] > g[x] ? r[x] : g[x], lo = r[x] < g[x] ? r[x] : g[x];
+        hi = hi > b[x] ? hi : b[x];
+        lo = lo < b[x] ? lo : b[x];
+        out[x] = static_cast<byte>((hi + lo) / 2);
+    }
+}
+
+// Separate R, G, B, A and L planes in one aligned block, rows padded to
+// PLANE_ALIGN so kernels can run whole vectors over any row. The block is
+// kept across resize() calls that do not grow it.
+class PixelPlanes {
+public:
+    int width = 0, height = 0;
+    size_t stride = 0;
+
+    PixelPlanes() = default;
+    PixelPlanes(PixelPlanes&&) noexcept = default;
+    PixelPlanes& operator=(PixelPlanes&&) noexcept = default;
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        stride = (size_t(w) + PLANE_ALIGN - 1) / PLANE_ALIGN * PLANE_ALIGN;
+        size_t needed = plane_size() * PLANE_COUNT;
+        if(needed > capacity) {
+            storage.reset(static_cast<byte*>(::operator new(needed, std::align_val_t(PLANE_ALIGN))));
+            memset(storage.get(), 0, needed);
+            capacity = needed;
+        }
+    }
+
+    size_t pixel_count() const { return size_t(width) * height; }
+    size_t plane_size() const { return stride * height; }
+
+    byte* plane(Channel c) const { return storage.get() + c * plane_size(); }
+    byte* row(Channel c, int y) const { return plane(c) + size_t(y) * stride; }
+    PlaneView view(Channel c) const { return {plane(c), width, height, stride}; }
+    PlaneView tile(Channel c, int x, int y, int w, int h) const { return view(c).tile(x, y, w, h); }
+
+    // Splits interleaved 1 (grey), 3 (RGB) or 4 (RGBA) channel pixels, as
+    // returned by stbi_load; grey and RGB input get an opaque alpha plane.
+    // Derives L as well unless `lightness` is false, for input that is
+    // composited (and gets its L) later.
+    void deinterleave(const byte* pixels, int w, int h, int channels, bool lightness = true) {
+        resize(w, h);
+        for(int y = 0; y < h; y++) {
+            const byte* in = pixels + size_t(y) * w * channels;
+            byte *r = row(CHANNEL_R, y), *g = row(CHANNEL_G, y), *b = row(CHANNEL_B, y), *a = row(CHANNEL_A, y);
+            if(channels == 4) deinterleave_rgba(in, r, g, b, a, w);
+            else if(channels == 1) {
+                for(byte* plane : {r, g, b}) memcpy(plane, in, w);
+                memset(a, 255, w);
+            } else {
+                deinterleave_rgb(in, r, g, b, w);
+                memset(a, 255, w);
+            }
+        }
+        if(lightness) derive_lightness();
+    }
+
+    void derive_lightness() {
+        for(int y = 0; y < height; y++)
+            lightness_row(row(CHANNEL_R, y), row(CHANNEL_G, y), row(CHANNEL_B, y), row(CHANNEL_L, y), width);
+    }
+
+    // Box-filtered copy of `source` at w x h, for shrinking only. Colors are
+    // weighted by alpha, so transparent pixels do not bleed into the edges
+    // of what stays visible. `lightness` as for deinterleave().
+    void downsample(const PixelPlanes& source, int w, int h, bool lightness = true) {
+        resize(w, h);
+        for(int y = 0; y < h; y++) {
+            int y0 = int(int64_t(y) * source.height / h), y1 = std::max(y0 + 1, int(int64_t(y + 1) * source.height / h));
+            byte *r = row(CHANNEL_R, y), *g = row(CHANNEL_G, y), *b = row(CHANNEL_B, y), *a = row(CHANNEL_A, y);
+            for(int x = 0; x < w; x++) {
+                int x0 = int(int64_t(x) * source.width / w), x1 = std::max(x0 + 1, int(int64_t(x + 1) * source.width / w));
+                uint64_t sum[3] = {}, alpha = 0;
+                for(int sy = y0; sy < y1; sy++) {
+                    const byte *sr = source.row(CHANNEL_R, sy), *sg = source.row(CHANNEL_G, sy), *sb = source.row(CHANNEL_B, sy), *sa = source.row(CHANNEL_A, sy);
+                    for(int sx = x0; sx < x1; sx++) {
+                        sum[0] += uint32_t(sr[sx]) * sa[sx];
+                        sum[1] += uint32_t(sg[sx]) * sa[sx];
+                        sum[2] += uint32_t(sb[sx]) * sa[sx];
+                        alpha += sa[sx];
+                    }
+                }
+                uint64_t count = uint64_t(y1 - y0) * (x1 - x0);
+                r[x] = alpha ? static_cast<byte>(sum[0] / alpha) : 0;
+                g[x] = alpha ? static_cast<byte>(sum[1] / alpha) : 0;
+                b[x] = alpha ? static_cast<byte>(sum[2] / alpha) : 0;
+                a[x] = static_cast<byte>(alpha / count);
+            }
+        }
+        if(lightness) derive_lightness();
+    }
+
+    RGBA pixel(int x, int y) const {
+        return {row(CHANNEL_R, y)[x], row(CHANNEL_G, y)[x], row(CHANNEL_B, y)[x], row(CHANNEL_A, y)[x]};
+    }
+
+private:
+    std::unique_ptr<byte, AlignedDelete> storage;
+    size_t capacity = 0;
+
+    // Bytes 0, 1, 2, 3 of each 32-bit pixel, masked out and narrowed with
+    // two saturating packs: 16 pixels per step on plain SSE2.
+    static void deinterleave_rgba(const byte* in, byte* r, byte* g, byte* b, byte* a, int width) {
+        int x = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128i mask = _mm_set1_epi32(0xff);
+        for(; x + 16 <= width; x += 16) {
+            __m128i v[4];
+            for(int i = 0; i < 4; i++) v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x * 4 + i * 16));
+            auto channel = [&](int shift) {
+                __m128i c[4];
+                for(int i = 0; i < 4; i++) c[i] = _mm_and_si128(_mm_srli_epi32(v[i], shift), mask);
+                return _mm_packus_epi16(_mm_packs_epi32(c[0], c[1]), _mm_packs_epi32(c[2], c[3]));
+            };
+            _mm_store_si128(reinterpret_cast<__m128i*>(r + x), channel(0));
+            _mm_store_si128(reinterpret_cast<__m128i*>(g + x), channel(8));
+            _mm_store_si128(reinterpret_cast<__m128i*>(b + x), channel(16));
+            _mm_store_si128(reinterpret_cast<__m128i*>(a + x), channel(24));
+        }
+#endif
+        for(; x < width; x++) {
+            r[x] = in[x * 4];
+            g[x] = in[x * 4 + 1];
+            b[x] = in[x * 4 + 2];
+            a[x] = in[x * 4 + 3];
+        }
+    }
+
+    // With SSSE3 each plane gathers its 16 bytes out of three loads with one
+    // byte shuffle per load.
+    static void deinterleave_rgb(const byte* in, byte* r, byte* g, byte* b, int width) {
+        int x = 0;
+#if defined(__SSSE3__)
+        auto shuffle = [](int channel, int part) {
+            alignas(16) signed char m[16];
+            for(int i = 0; i < 16; i++) {
+                int source = i * 3 + channel - part * 16;
+                m[i] = static_cast<signed char>(source >= 0 && source < 16 ? source : -1);
+            }
+            return _mm_load_si128(reinterpret_cast<const __m128i*>(m));
+        };
+        const __m128i masks[3][3] = {
+            {shuffle(0, 0), shuffle(0, 1), shuffle(0, 2)},
+            {shuffle(1, 0), shuffle(1, 1), shuffle(1, 2)},
+            {shuffle(2, 0), shuffle(2, 1), shuffle(2, 2)}
+        };
+        byte* out[3] = {r, g, b};
+        for(; x + 16 <= width; x += 16) {
+            __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x * 3));
+            __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x * 3 + 16));
+            __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x * 3 + 32));
+            for(int c = 0; c < 3; c++) {
+                __m128i plane = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, masks[c][0]), _mm_shuffle_epi8(v1, masks[c][1])), _mm_shuffle_epi8(v2, masks[c][2]));
+                _mm_store_si128(reinterpret_cast<__m128i*>(out[c] + x), plane);
+            }
+        }
+#endif
+        for(; x < width; x++) {
+            r[x] = in[x * 3];
+            g[x] = in[x * 3 + 1];
+            b[x] = in[x * 3 + 2];
+        }
+    }
+};
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../stb/stb_image_write.h"
+
+// Encoder knobs for PNG output. level follows zlib (0 stores, 9 searches
+// hardest); filter is a stb_image_write filter type, -1 for adaptive; strips
+// > 1 deflates that many slices of the filtered image in parallel.
+struct PngOptions {
+    int level = 6;
+    int filter = -1;
+    int strips = 1;
+};
+
+inline bool parse_png_filter(const std::string& value, int& filter) {
+    const char* names[] = {"none", "sub", "up", "avg", "paeth"};
+    for(int i = 0; i < 5; i++)
+        if(value == names[i]) {
+            filter = i;
+            return true;
+        }
+    filter = -1;
+    return value == "adaptive";
+}
+
+// stb_image_write asks for compression through STBIW_ZLIB_COMPRESS with only
+// a quality argument, so the strip count travels alongside it.
+inline int& png_deflate_strips() {
+    static int strips = 1;
+    return strips;
+}
+
+// Deflate bit writer, least significant bit first.
+struct DeflateBits {
+    std::vector<unsigned char> out;
+    uint64_t bits = 0;
+    int count = 0;
+
+    void put(uint32_t value, int length) {
+        bits |= uint64_t(value) << count;
+        count += length;
+        while(count >= 8) {
+            out.push_back(static_cast<unsigned char>(bits));
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    // Huffman codes are defined most significant bit first.
+    void put_code(uint32_t code, int length) {
+        uint32_t reversed = 0;
+        for(int i = 0; i < length; i++, code >>= 1) reversed = (reversed << 1) | (code & 1);
+        put(reversed, length);
+    }
+
+    void align() {
+        if(count) put(0, 8 - count);
+    }
+};
+
+inline void deflate_literal(DeflateBits& bits, int symbol) {
+    if(symbol < 144) bits.put_code(0x30 + symbol, 8);
+    else if(symbol < 256) bits.put_code(0x190 + symbol - 144, 9);
+    else if(symbol < 280) bits.put_code(symbol - 256, 7);
+    else bits.put_code(0xc0 + symbol - 280, 8);
+}
+
+inline void deflate_match(DeflateBits& bits, int length, int distance) {
+    static const unsigned short length_base[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258, 259};
+    static const unsigned char length_extra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static const unsigned short distance_base[] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    static const unsigned char distance_extra[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    int l = 0;
+    while(length_base[l + 1] <= length) l++;
+    deflate_literal(bits, 257 + l);
+    if(length_extra[l]) bits.put(length - length_base[l], length_extra[l]);
+
+    // Code 29 covers 24577-32768, the whole window; there is no code 30.
+    int d = 0;
+    while(d < 29 && distance_base[d + 1] <= distance) d++;
+    bits.put_code(d, 5);
+    if(distance_extra[d]) bits.put(distance - distance_base[d], distance_extra[d]);
+}
+
+// One fixed-Huffman block over data[0, size) with a hash-chain LZ77 search.
+// The window never reaches outside the slice, so slices compress independently.
+inline void deflate_block(DeflateBits& bits, const unsigned char* data, int size, int level, bool final) {
+    const int HASH_BITS = 15, WINDOW = 32768, MIN_MATCH = 3, MAX_MATCH = 258;
+    const int max_chain = level <= 1 ? 4 : (level <= 5 ? 16 << (level - 2) : 128 << (level - 6));
+
+    bits.put(final ? 1 : 0, 1);
+    bits.put(1, 2);
+
+    std::vector<int> head(size_t(1) << HASH_BITS, -1), prev(WINDOW, -1);
+    auto hash = [&](int i) {
+        uint32_t v = data[i] | (data[i + 1] << 8) | (data[i + 2] << 16);
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    };
+    auto insert = [&](int i) {
+        uint32_t h = hash(i);
+        prev[i & (WINDOW - 1)] = head[h];
+        head[h] = i;
+    };
+
+    int i = 0;
+    while(i < size) {
+        int best_length = 0, best_distance = 0;
+        if(i + MIN_MATCH <= size) {
+            int limit = size - i < MAX_MATCH ? size - i : MAX_MATCH;
+            int candidate = head[hash(i)];
+            for(int chain = 0; candidate >= 0 && i - candidate <= WINDOW && chain < max_chain; chain++) {
+                if(data[candidate + best_length] == data[i + best_length]) {
+                    int length = 0;
+                    while(length < limit && data[candidate + length] == data[i + length]) length++;
+                    if(length > best_length) {
+                        best_length = length;
+                        best_distance = i - candidate;
+                        if(length == limit) break;
+                    }
+                }
+                int next = prev[candidate & (WINDOW - 1)];
+                if(next >= candidate) break;
+                candidate = next;
+            }
+            insert(i);
+        }
+
+        if(best_length >= MIN_MATCH) {
+            deflate_match(bits, best_length, best_distance);
+            for(int j = i + 1; j < i + best_length && j + MIN_MATCH <= size; j++) insert(j);
+            i += best_length;
+        } else {
+            deflate_literal(bits, data[i]);
+            i++;
+        }
+    }
+    deflate_literal(bits, 256);
+}
+
+inline uint32_t adler32(const unsigned char* data, size_t size) {
+    uint32_t a = 1, b = 0;
+    while(size) {
+        size_t n = size < 5552 ? size : 5552;
+        size -= n;
+        for(size_t i = 0; i < n; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += n;
+    }
+    return (b << 16) | a;
+}
+
+// Zlib stream for stb_image_write (see STBIW_ZLIB_COMPRESS). Level 0 emits
+// stored blocks. Otherwise the input is cut into png_deflate_strips() slices
+// deflated on their own threads; every slice but the last ends with an empty
+// stored block, which byte-aligns it so the slices simply concatenate.
+inline unsigned char* png_deflate(unsigned char* data, int size, int* out_size, int level) {
+    DeflateBits header;
+    header.out = {0x78, 0x01};
+
+    std::vector<DeflateBits> slices;
+    if(level <= 0) {
+        int offset = 0;
+        do {
+            int n = size - offset < 65535 ? size - offset : 65535;
+            header.put(offset + n == size ? 1 : 0, 1);
+            header.put(0, 2);
+            header.align();
+            header.put(n, 16);
+            header.put(~n & 0xffff, 16);
+            header.out.insert(header.out.end(), data + offset, data + offset + n);
+            offset += n;
+        } while(offset < size);
+    } else {
+        int strips = png_deflate_strips();
+        if(strips < 1) strips = 1;
+        if(strips > 1 && size / strips < (1 << 16)) strips = size >> 16 > 1 ? size >> 16 : 1;
+        slices.resize(strips);
+
+        auto compress = [&](int s) {
+            int first = int(int64_t(size) * s / strips), last = int(int64_t(size) * (s + 1) / strips);
+            bool final = s == strips - 1;
+            deflate_block(slices[s], data + first, last - first, level, final);
+            if(!final) {
+                slices[s].put(0, 3);
+                slices[s].align();
+                slices[s].put(0x0000, 16);
+                slices[s].put(0xffff, 16);
+            }
+            slices[s].align();
+        };
+
+        std::vector<std::thread> workers;
+        for(int s = 1; s < strips; s++) workers.emplace_back(compress, s);
+        compress(0);
+        for(std::thread& worker : workers) worker.join();
+    }
+
+    size_t total = header.out.size() + 4;
+    for(const DeflateBits& slice : slices) total += slice.out.size();
+    unsigned char* out = static_cast<unsigned char*>(malloc(total));
+    if(!out) return nullptr;
+
+    unsigned char* p = out;
+    memcpy(p, header.out.data(), header.out.size());
+    p += header.out.size();
+    for(const DeflateBits& slice : slices) {
+        memcpy(p, slice.out.data(), slice.out.size());
+        p += slice.out.size();
+    }
+    uint32_t checksum = adler32(data, size_t(size));
+    for(int i = 3; i >= 0; i--) *p++ = static_cast<unsigned char>(checksum >> (i * 8));
+    *out_size = static_cast<int>(total);
+    return out;
+}
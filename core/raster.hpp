@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include "image.hpp"
+#include "glyphs.hpp"
+#include "atari_font.hpp"
+
+// Coverage masks for all 256 byte values, each cell_width x cell_height.
+// Characters the font does not provide stay blank.
+struct BitmapFont {
+    int cell_width = 0, cell_height = 0;
+    std::vector<byte> masks;
+
+    const byte* mask(unsigned char ch) const { return masks.data() + size_t(ch) * cell_width * cell_height; }
+};
+
+// The vendored Atari font strip, built in: 111 glyphs of 9x9 pixels in one
+// row, starting 16 codes below the space character.
+inline bool load_atari_font(BitmapFont& font) {
+    int width, height, comp;
+    byte* strip = stbi_load_from_memory(ATARI_FONT_PNG, sizeof(ATARI_FONT_PNG), &width, &height, &comp, 1);
+    if(!strip) return false;
+
+    const int cell = 9, first = ' ' - 16;
+    font.cell_width = cell;
+    font.cell_height = height;
+    font.masks.assign(256 * size_t(cell) * height, 0);
+    for(int glyph = 0; glyph < width / cell; glyph++) {
+        int ch = first + glyph;
+        if(ch < 0 || ch > 255) continue;
+        byte* mask = font.masks.data() + size_t(ch) * cell * height;
+        for(int y = 0; y < height; y++)
+            memcpy(mask + y * cell, strip + size_t(y) * width + glyph * cell, cell);
+    }
+    stbi_image_free(strip);
+    return true;
+}
+
+inline BitmapFont bitmap_font(const GlyphSet& set) {
+    BitmapFont font;
+    font.cell_width = set.cell_width;
+    font.cell_height = set.cell_height;
+    font.masks.assign(256 * set.cell_size(), 0);
+    for(size_t i = 0; i < set.glyphs.size(); i++)
+        memcpy(font.masks.data() + size_t(static_cast<unsigned char>(set.glyphs[i])) * set.cell_size(), set.bitmap(i), set.cell_size());
+    return font;
+}
+
+// The legacy Windows console color table, in Color enum order.
+inline const RGBA* default_console_palette() {
+    static const RGBA palette[16] = {
+        {0, 0, 0}, {0, 0, 128}, {0, 128, 0}, {0, 128, 128},
+        {128, 0, 0}, {128, 0, 128}, {128, 128, 0}, {192, 192, 192},
+        {128, 128, 128}, {0, 0, 255}, {0, 255, 0}, {0, 255, 255},
+        {255, 0, 0}, {255, 0, 255}, {255, 255, 0}, {255, 255, 255}
+    };
+    return palette;
+}
+
+// Draws a columns x rows grid of cells into an RGB buffer. Glyphs are read
+// with `stride` bytes per row (columns + 1 for newline separated text); fg/bg
+// are per-cell palette indices. Blank mask rows are a memcpy of a prebuilt
+// background run; inked rows copy solid mask pixels from fg/bg and blend the rest.
+inline std::vector<byte> rasterize_cells(const char* glyphs, size_t stride, int columns, int rows, const byte* fg, const byte* bg, const RGBA* palette, const BitmapFont& font) {
+    const int cw = font.cell_width, ch = font.cell_height;
+    const size_t out_stride = size_t(columns) * cw * 3;
+    std::vector<byte> pixels(out_stride * rows * ch);
+    std::vector<byte> background_run(size_t(cw) * 3);
+
+    // Which mask rows have any ink, per glyph.
+    std::vector<byte> inked(256 * size_t(ch), 0);
+    for(int g = 0; g < 256; g++)
+        for(int y = 0; y < ch; y++)
+            for(int x = 0; x < cw; x++)
+                if(font.mask(static_cast<unsigned char>(g))[y * cw + x]) inked[g * ch + y] = 1;
+
+    for(int row = 0; row < rows; row++) {
+        for(int column = 0; column < columns; column++) {
+            size_t cell = size_t(row) * columns + column;
+            unsigned char glyph = static_cast<unsigned char>(glyphs[size_t(row) * stride + column]);
+            const RGBA& f = palette[fg[cell]];
+            const RGBA& b = palette[bg[cell]];
+            for(int x = 0; x < cw; x++) {
+                background_run[x * 3] = b.r;
+                background_run[x * 3 + 1] = b.g;
+                background_run[x * 3 + 2] = b.b;
+            }
+
+            const byte* mask = font.mask(glyph);
+            byte* out = pixels.data() + size_t(row) * ch * out_stride + size_t(column) * cw * 3;
+            for(int y = 0; y < ch; y++, out += out_stride) {
+                if(!inked[glyph * ch + y]) {
+                    memcpy(out, background_run.data(), background_run.size());
+                    continue;
+                }
+                const byte* m = mask + y * cw;
+                for(int x = 0; x < cw; x++) {
+                    int a = m[x];
+                    if(a == 0 || a == 255) {
+                        const RGBA& c = a ? f : b;
+                        out[x * 3] = c.r;
+                        out[x * 3 + 1] = c.g;
+                        out[x * 3 + 2] = c.b;
+                        continue;
+                    }
+                    out[x * 3] = static_cast<byte>((f.r * a + b.r * (255 - a) + 127) / 255);
+                    out[x * 3 + 1] = static_cast<byte>((f.g * a + b.g * (255 - a) + 127) / 255);
+                    out[x * 3 + 2] = static_cast<byte>((f.b * a + b.b * (255 - a) + 127) / 255);
+                }
+            }
+        }
+    }
+    return pixels;
+}
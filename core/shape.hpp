@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "image.hpp"
+#include "glyphs.hpp"
+#include "tone.hpp"
+
+// Structure-aware glyph selection: a cell is described by the mean density of
+// a 3x3 grid of regions, quantized to 2 bits each. The resulting 18-bit key
+// indexes a table that is filled lazily with the nearest glyph, so a cell
+// costs nine region sums and (almost always) one table load.
+constexpr int SHAPE_GRID = 3;
+constexpr int SHAPE_REGIONS = SHAPE_GRID * SHAPE_GRID;
+constexpr int SHAPE_LEVELS = 4;
+constexpr int SHAPE_BITS = 2;
+constexpr size_t SHAPE_KEYS = size_t(1) << (SHAPE_REGIONS * SHAPE_BITS);
+
+typedef std::array<float, SHAPE_REGIONS> ShapeFeatures;
+
+inline ShapeFeatures glyph_features(const GlyphSet& set, size_t glyph) {
+    ShapeFeatures features;
+    const byte* cell = set.bitmap(glyph);
+    for(int ry = 0; ry < SHAPE_GRID; ry++) {
+        for(int rx = 0; rx < SHAPE_GRID; rx++) {
+            int x0 = rx * set.cell_width / SHAPE_GRID, x1 = (rx + 1) * set.cell_width / SHAPE_GRID;
+            int y0 = ry * set.cell_height / SHAPE_GRID, y1 = (ry + 1) * set.cell_height / SHAPE_GRID;
+            uint32_t sum = 0;
+            for(int y = y0; y < y1; y++)
+                for(int x = x0; x < x1; x++)
+                    sum += cell[y * set.cell_width + x];
+            int area = (x1 - x0) * (y1 - y0);
+            features[ry * SHAPE_GRID + rx] = area ? sum / (255.0f * area) : 0.0f;
+        }
+    }
+    return features;
+}
+
+class ShapeMatcher {
+public:
+    explicit ShapeMatcher(const GlyphSet& set);
+
+    char match(uint32_t key);
+
+private:
+    std::string glyphs;
+    std::vector<ShapeFeatures> features;
+    std::vector<char> table; // 0 = not computed yet
+};
+
+inline ShapeMatcher::ShapeMatcher(const GlyphSet& set) : glyphs(set.glyphs), table(SHAPE_KEYS, 0) {
+    // Glyphs never reach full coverage, so scale their regions to the
+    // densest region in the set to share the image's 0..1 range.
+    float densest = 0.0f;
+    for(size_t i = 0; i < set.glyphs.size(); i++) {
+        features.push_back(glyph_features(set, i));
+        for(float f : features.back()) densest = f > densest ? f : densest;
+    }
+    if(densest > 0.0f)
+        for(ShapeFeatures& f : features)
+            for(float& v : f) v /= densest;
+}
+
+inline char match_features(const std::string& glyphs, const std::vector<ShapeFeatures>& features, const ShapeFeatures& target) {
+    size_t best = 0;
+    float best_distance = 1e30f;
+    for(size_t i = 0; i < features.size(); i++) {
+        float d = 0.0f;
+        for(int r = 0; r < SHAPE_REGIONS; r++) {
+            float delta = features[i][r] - target[r];
+            d += delta * delta;
+        }
+        if(d < best_distance) {
+            best_distance = d;
+            best = i;
+        }
+    }
+    return glyphs.empty() ? ' ' : glyphs[best];
+}
+
+inline char ShapeMatcher::match(uint32_t key) {
+    char& entry = table[key];
+    if(!entry) {
+        ShapeFeatures target;
+        for(int r = 0; r < SHAPE_REGIONS; r++) {
+            int level = (key >> (r * SHAPE_BITS)) & (SHAPE_LEVELS - 1);
+            target[r] = level / float(SHAPE_LEVELS - 1);
+        }
+        entry = match_features(glyphs, features, target);
+    }
+    return entry;
+}
+
+// Region bounds and quantization thresholds for one cell size, worked out
+// once per image so that keying a cell takes no divisions. A region's level
+// is the number of thresholds its (tone mapped) sum reaches, the same as
+// rounding its mean density to SHAPE_LEVELS steps.
+struct ShapeLayout {
+    int begin[SHAPE_GRID], end[SHAPE_GRID];
+    uint32_t thresholds[SHAPE_REGIONS][SHAPE_LEVELS - 1];
+
+    explicit ShapeLayout(int cell) {
+        for(int i = 0; i < SHAPE_GRID; i++) {
+            begin[i] = i * cell / SHAPE_GRID;
+            end[i] = (i + 1) * cell / SHAPE_GRID;
+        }
+        for(int ry = 0; ry < SHAPE_GRID; ry++) {
+            for(int rx = 0; rx < SHAPE_GRID; rx++) {
+                int64_t area = int64_t(end[rx] - begin[rx]) * (end[ry] - begin[ry]);
+                for(int level = 1; level < SHAPE_LEVELS; level++) {
+                    // level <= (sum * (LEVELS - 1) + area * 127) / (255 * area)
+                    int64_t needed = level * 255 * area - area * 127;
+                    thresholds[ry * SHAPE_GRID + rx][level - 1] = needed <= 0 ? 0 : uint32_t((needed + SHAPE_LEVELS - 2) / (SHAPE_LEVELS - 1));
+                }
+            }
+        }
+    }
+
+    uint32_t level(int region, uint32_t sum) const {
+        uint32_t level = 0;
+        for(int i = 0; i < SHAPE_LEVELS - 1; i++) level += sum >= thresholds[region][i];
+        return level;
+    }
+};
+
+// One glyph per cell x cell block; partial blocks at the right/bottom edges
+// are dropped. Each band of `cell` rows is first reduced to running column
+// sums per region row, so every pixel is read once and a region sum is a
+// single subtraction.
+inline std::string shape_ascii_image(const byte* lightness, int width, int height, int cell, ShapeMatcher& matcher, const ToneCurve& curve) {
+    int columns = width / cell, rows = height / cell;
+    std::string output;
+    if(!columns || !rows) return output;
+    output.assign(size_t(columns + 1) * rows - 1, '\n');
+
+    ShapeLayout layout(cell);
+    // Without a tone curve the column sums are plain byte adds, which the
+    // compiler vectorizes; the lookup would stop it.
+    bool toned = curve != identity_curve();
+    size_t span = size_t(columns) * cell;
+    std::vector<uint32_t> sums(span), prefix(SHAPE_GRID * (span + 1));
+    for(int row = 0; row < rows; row++) {
+        const byte* band = lightness + size_t(row) * cell * width;
+        for(int ry = 0; ry < SHAPE_GRID; ry++) {
+            std::fill(sums.begin(), sums.end(), 0);
+            for(int y = layout.begin[ry]; y < layout.end[ry]; y++) {
+                const byte* line = band + size_t(y) * width;
+                if(toned)
+                    for(size_t x = 0; x < span; x++) sums[x] += curve[line[x]];
+                else
+                    for(size_t x = 0; x < span; x++) sums[x] += line[x];
+            }
+            uint32_t* running = &prefix[ry * (span + 1)];
+            running[0] = 0;
+            for(size_t x = 0; x < span; x++) running[x + 1] = running[x] + sums[x];
+        }
+
+        char* out = &output[size_t(row) * (columns + 1)];
+        for(int column = 0; column < columns; column++) {
+            size_t left = size_t(column) * cell;
+            uint32_t key = 0;
+            for(int ry = 0; ry < SHAPE_GRID; ry++) {
+                const uint32_t* running = &prefix[ry * (span + 1) + left];
+                for(int rx = 0; rx < SHAPE_GRID; rx++) {
+                    int region = ry * SHAPE_GRID + rx;
+                    key |= layout.level(region, running[layout.end[rx]] - running[layout.begin[rx]]) << (region * SHAPE_BITS);
+                }
+            }
+            out[column] = matcher.match(key);
+        }
+    }
+    return output;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "image.hpp"
+#include "planes.hpp"
+
+typedef std::array<uint32_t, 256> Histogram;
+typedef std::array<byte, 256> ToneCurve;
+
+enum class Tone {
+    NONE, LEVELS, EQUALIZE
+};
+
+inline bool parse_tone(const std::string& name, Tone& tone) {
+    if(name == "none") tone = Tone::NONE;
+    else if(name == "levels") tone = Tone::LEVELS;
+    else if(name == "equalize") tone = Tone::EQUALIZE;
+    else return false;
+    return true;
+}
+
+inline byte lightness(const RGBA& color) {
+    return (color.max_value() + color.min_value()) / 2;
+}
+
+// The L plane without row padding, as the cell kernels index it. `plane`
+// keeps its capacity, so a reused vector is only grown, never reallocated.
+inline void lightness_plane(const PixelPlanes& planes, std::vector<byte>& plane) {
+    plane.resize(planes.pixel_count());
+    for(int y = 0; y < planes.height; y++)
+        memcpy(plane.data() + size_t(y) * planes.width, planes.row(CHANNEL_L, y), planes.width);
+}
+
+// One pass over the plane; large planes are split across threads that each
+// fill a private histogram, merged at the end. With a `mask` only pixels it
+// marks non-zero are counted.
+inline Histogram lightness_histogram(const byte* plane, size_t count, const byte* mask = nullptr) {
+    constexpr size_t MIN_PER_THREAD = 1 << 18;
+    size_t threads = std::thread::hardware_concurrency();
+    if(threads == 0) threads = 1;
+    if(threads > count / MIN_PER_THREAD) threads = count / MIN_PER_THREAD;
+    if(threads == 0) threads = 1;
+
+    std::vector<Histogram> partial(threads);
+    auto count_range = [plane, mask](Histogram& histogram, size_t begin, size_t end) {
+        histogram.fill(0);
+        if(mask) {
+            for(size_t i = begin; i < end; i++)
+                histogram[plane[i]] += mask[i] != 0;
+        } else {
+            for(size_t i = begin; i < end; i++)
+                histogram[plane[i]]++;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    size_t chunk = count / threads;
+    for(size_t t = 1; t < threads; t++)
+        workers.emplace_back(count_range, std::ref(partial[t]), t * chunk, (t + 1 == threads) ? count : (t + 1) * chunk);
+    count_range(partial[0], 0, threads == 1 ? count : chunk);
+    for(std::thread& worker : workers)
+        worker.join();
+
+    Histogram histogram = partial[0];
+    for(size_t t = 1; t < threads; t++)
+        for(size_t v = 0; v < 256; v++)
+            histogram[v] += partial[t][v];
+    return histogram;
+}
+
+inline ToneCurve identity_curve() {
+    ToneCurve curve;
+    for(size_t v = 0; v < 256; v++) curve[v] = static_cast<byte>(v);
+    return curve;
+}
+
+// Stretches the range between the `clip` low and high percentiles to 0..255.
+inline ToneCurve auto_levels(const Histogram& histogram, float clip = 0.005f) {
+    uint64_t total = 0;
+    for(uint32_t n : histogram) total += n;
+    uint64_t cut = static_cast<uint64_t>(total * clip);
+
+    int lo = 0, hi = 255;
+    for(uint64_t acc = 0; lo < 255 && (acc += histogram[lo]) <= cut; lo++);
+    for(uint64_t acc = 0; hi > 0 && (acc += histogram[hi]) <= cut; hi--);
+    if(hi <= lo) return identity_curve();
+
+    ToneCurve curve;
+    for(int v = 0; v < 256; v++) {
+        int mapped = (v - lo) * 255 / (hi - lo);
+        curve[v] = static_cast<byte>(mapped < 0 ? 0 : (mapped > 255 ? 255 : mapped));
+    }
+    return curve;
+}
+
+// Contrast-limited histogram equalization: bins above `clip_limit` times the
+// mean are clipped and the excess spread evenly before building the CDF,
+// which is then stretched so the darkest occupied level maps to 0 and the
+// brightest to 255.
+inline ToneCurve equalize(const Histogram& histogram, float clip_limit = 4.0f) {
+    uint64_t total = 0;
+    for(uint32_t n : histogram) total += n;
+    if(!total) return identity_curve();
+
+    uint64_t limit = static_cast<uint64_t>(clip_limit * total / 256) + 1;
+    uint64_t excess = 0;
+    std::array<uint64_t, 256> cdf;
+    for(size_t v = 0; v < 256; v++) {
+        cdf[v] = histogram[v] > limit ? limit : histogram[v];
+        excess += histogram[v] - cdf[v];
+    }
+    uint64_t acc = 0;
+    for(size_t v = 0; v < 256; v++) cdf[v] = acc += cdf[v] + excess / 256;
+
+    int first = 0, last = 255;
+    while(!histogram[first]) first++;
+    while(!histogram[last]) last--;
+    if(first == last) return identity_curve();
+
+    ToneCurve curve;
+    uint64_t lo = cdf[first], range = cdf[last] - lo;
+    for(int v = 0; v < 256; v++) {
+        uint64_t mapped = v <= first ? 0 : (cdf[v] - lo) * 255 / range;
+        curve[v] = static_cast<byte>(mapped > 255 ? 255 : mapped);
+    }
+    return curve;
+}
+
+// The curve fitted to the pixels `mask` marks, or to all of them without one.
+inline ToneCurve tone_curve(Tone tone, const byte* plane, size_t count, const byte* mask = nullptr) {
+    if(tone == Tone::NONE) return identity_curve();
+    Histogram histogram = lightness_histogram(plane, count, mask);
+    return tone == Tone::LEVELS ? auto_levels(histogram) : equalize(histogram);
+}
+
+// Folds a tone curve and a ramp into one 256-entry grey -> entry table.
+template <typename T, typename Ramp>
+std::array<T, 256> ramp_lut(const Ramp& ramp, size_t ramp_size, const ToneCurve& curve) {
+    std::array<T, 256> lut;
+    for(size_t v = 0; v < 256; v++)
+        lut[v] = ramp[static_cast<size_t>(map(curve[v], 0, 255, 0, ramp_size - 1))];
+    return lut;
+}
@@ -1,4 +1,4 @@
 @echo off
 cls
-g++ asciimage.cpp -o asciimage.exe -std=c++17
-g++ asciimage_loop.cpp -o asciimage_loop.exe -std=c++17
\ No newline at end of file
+g++ asciimage.cpp -o asciimage.exe -std=c++17 -O3 -march=native
+g++ asciimage_loop.cpp -o asciimage_loop.exe -std=c++17 -O3 -march=native
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include "../core/image.hpp"
+#include "../core/cells.hpp"
+#include "../core/ansi.hpp"
+
+struct ConsoleSize {
+    int columns = 0, rows = 0;
+};
+
+// What the console on stdout can do. Probed once per process, so batch items
+// and redraws reuse it; only the size is queried each time (size()), since
+// the window can change under a running program.
+struct TerminalCaps {
+    // Output reaches a terminal rather than a file or pipe.
+    bool tty = false;
+    // The richest color encoding the terminal understands; palettes are sent
+    // with the cheapest one that shows them (cheapest_colors).
+    ColorSupport colors = ColorSupport::NONE;
+    // The 16 attribute colors themselves can be redefined, as on the
+    // Windows console, so any palette shows exactly at BASIC cost.
+    bool palette = false;
+};
+
+struct ConsoleEvent {
+    enum Type { NONE, KEY, RESIZE } type = NONE;
+    int key = 0;
+    ConsoleSize size;
+};
+
+// Everything the converter needs from a console, so the same pipeline runs on
+// the Windows console (WinsoleConsole) and on POSIX terminals (PosixConsole).
+// Frames are cell grids as in core/cells.hpp: columns x rows glyphs and
+// attributes without row separators, attribute nibbles indexing the palette.
+class ConsoleBackend {
+public:
+    virtual ~ConsoleBackend() = default;
+
+    virtual bool init() = 0;
+    virtual ConsoleSize size() const = 0;
+    virtual const TerminalCaps& capabilities() const = 0;
+    // The colors cells marked AUTO keep.
+    virtual CellAttr default_attr() const = 0;
+
+    // Makes the 16 attribute colors show as `palette`, through the cheapest
+    // encoding the console has for it; false where it can only approximate
+    // the palette with the colors it has.
+    virtual bool set_palette(const RGBA* palette) = 0;
+    virtual bool write_text(const char* text, size_t length) = 0;
+    // Outside screen mode a frame is printed where the cursor is; inside it,
+    // it replaces the whole screen at once.
+    virtual bool write_frame(const char* glyphs, const CellAttr* attrs, int columns, int rows) = 0;
+
+    // Full-screen, flicker-free mode until leave_screen(); the previous
+    // console contents come back afterwards.
+    virtual bool enter_screen() = 0;
+    virtual void leave_screen() = 0;
+
+    // Waits up to timeout_ms (forever if negative) for a key press or a
+    // resize; false on timeout.
+    virtual bool poll_event(ConsoleEvent& event, int timeout_ms) = 0;
+};
+
+// Keeps the output up until a key is pressed, drawing `cells` again (if any)
+// whenever the console is resized. Without a timeout poll_event() only fails
+// once no input can ever come (stdin closed), which ends the wait as well.
+inline void wait_key(ConsoleBackend& console, const CellGrid* cells = nullptr) {
+    ConsoleEvent event;
+    while(console.poll_event(event, -1)) {
+        if(event.type == ConsoleEvent::KEY) break;
+        if(event.type == ConsoleEvent::RESIZE && cells)
+            console.write_frame(cells->glyphs.data(), cells->attrs.data(), cells->columns, cells->rows);
+    }
+}
+
+#ifdef _WIN32
+    #include "winsole_console.hpp"
+    typedef WinsoleConsole PlatformConsole;
+#else
+    #include "posix_console.hpp"
+    typedef PosixConsole PlatformConsole;
+#endif
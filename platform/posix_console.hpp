@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "console.hpp"
+#include "../core/raster.hpp"
+
+// The terminal on stdout as far as the environment tells, without a round
+// trip to the terminal itself: not a tty or a non-empty NO_COLOR means no
+// color, as does a TERM that is unset or "dumb". COLORTERM=truecolor|24bit
+// or a *-direct TERM means RGB, a *256color* TERM the xterm table, and any
+// other TERM the basic 16 colors. `tty` says whether stdout is a terminal.
+inline TerminalCaps probe_terminal(bool tty) {
+    TerminalCaps caps;
+    caps.tty = tty;
+    const char* no_color = getenv("NO_COLOR");
+    const char* term = getenv("TERM");
+    if(!caps.tty || (no_color && *no_color) || !term || !*term || !strcmp(term, "dumb")) return caps;
+
+    const char* colorterm = getenv("COLORTERM");
+    std::string name = term;
+    bool direct = name.size() > 7 && name.compare(name.size() - 7, 7, "-direct") == 0;
+    if(direct || (colorterm && (!strcmp(colorterm, "truecolor") || !strcmp(colorterm, "24bit")))) caps.colors = ColorSupport::TRUECOLOR;
+    else if(name.find("256color") != std::string::npos) caps.colors = ColorSupport::XTERM256;
+    else caps.colors = ColorSupport::BASIC;
+    return caps;
+}
+
+// probe_terminal() of stdout, once for the whole process.
+inline const TerminalCaps& terminal_caps() {
+    static const TerminalCaps caps = probe_terminal(isatty(STDOUT_FILENO));
+    return caps;
+}
+
+// A VT terminal on stdout: size from TIOCGWINSZ, frames as ANSI escape text
+// through write(2), the alternate screen for screen mode and raw termios
+// input for events. Attribute indices are the terminal's own 16 colors until
+// a palette is set; that goes out in the cheapest encoding that shows it, or
+// is approximated with what the terminal has.
+class PosixConsole : public ConsoleBackend {
+public:
+    PosixConsole() = default;
+    PosixConsole(const PosixConsole&) = delete;
+    PosixConsole& operator=(const PosixConsole&) = delete;
+
+    ~PosixConsole() override {
+        leave_screen();
+        restore_input();
+    }
+
+    bool init() override {
+        caps = terminal_caps();
+        encoding = std::min(caps.colors, ColorSupport::BASIC);
+
+        struct sigaction action = {};
+        action.sa_handler = on_resize;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGWINCH, &action, nullptr);
+        return true;
+    }
+
+    ConsoleSize size() const override {
+        winsize window = {};
+        if(ioctl(STDOUT_FILENO, TIOCGWINSZ, &window) == 0 && window.ws_col && window.ws_row)
+            return {window.ws_col, window.ws_row};
+        const char* columns = getenv("COLUMNS");
+        const char* lines = getenv("LINES");
+        return {columns ? atoi(columns) : 80, lines ? atoi(lines) : 24};
+    }
+
+    const TerminalCaps& capabilities() const override { return caps; }
+
+    CellAttr default_attr() const override { return cell_attr(CELL_DEFAULT_COLOR, CELL_DEFAULT_COLOR); }
+
+    bool set_palette(const RGBA* table) override {
+        std::copy(table, table + 16, palette);
+        bool stock = memcmp(table, default_console_palette(), sizeof(palette)) == 0;
+        encoding = cheapest_colors(palette, stock, caps.colors);
+        approximated = !stock && encoding == ColorSupport::BASIC;
+        if(approximated) {
+            for(int i = 0; i < 16; i++) nearest[i] = nearest_basic(palette[i]);
+        }
+        if(stock || encoding == ColorSupport::TRUECOLOR) return true;
+        return encoding == ColorSupport::XTERM256 && xterm256_exact(palette);
+    }
+
+    bool write_text(const char* text, size_t length) override {
+        return write_all(text, length);
+    }
+
+    bool write_frame(const char* glyphs, const CellAttr* attrs, int columns, int rows) override {
+        attrs = shown_attrs(attrs, size_t(columns) * rows);
+        if(screen_active) {
+            screen.present(glyphs, attrs, columns, rows, palette, encoding);
+            return ok;
+        }
+        if(encoding == ColorSupport::NONE) {
+            for(int row = 0; row < rows; row++) {
+                write_all(glyphs + size_t(row) * columns, columns);
+                write_all("\n", 1);
+            }
+            return ok;
+        }
+        size_t cells = size_t(columns) * rows;
+        fg.resize(cells);
+        bg.resize(cells);
+        for(size_t i = 0; i < cells; i++) {
+            fg[i] = attr_fg(attrs[i]);
+            bg[i] = attr_bg(attrs[i]);
+        }
+        export_ansi(glyphs, columns, columns, rows, fg.data(), bg.data(), palette, encoding, sink, this);
+        return ok;
+    }
+
+    bool enter_screen() override {
+        if(!caps.tty) return false;
+        screen.enter();
+        screen_active = true;
+        return true;
+    }
+
+    void leave_screen() override {
+        screen.leave();
+        screen_active = false;
+    }
+
+    bool poll_event(ConsoleEvent& event, int timeout_ms) override {
+        raw_input();
+        pollfd input = {STDIN_FILENO, POLLIN, 0};
+        for(;;) {
+            if(resized()) {
+                resized() = 0;
+                event.type = ConsoleEvent::RESIZE;
+                event.size = size();
+                return true;
+            }
+            int ready = poll(&input, 1, timeout_ms);
+            if(ready < 0 && errno == EINTR) continue;
+            if(ready <= 0) return false;
+            unsigned char key;
+            if(read(STDIN_FILENO, &key, 1) != 1) return false;
+            event.type = ConsoleEvent::KEY;
+            event.key = key;
+            return true;
+        }
+    }
+
+private:
+    TerminalCaps caps;
+    bool ok = true;
+    ColorSupport encoding = ColorSupport::NONE;
+    RGBA palette[16] = {};
+    bool approximated = false;
+    byte nearest[16] = {};
+    std::vector<CellAttr> remapped;
+    std::vector<byte> fg, bg;
+    AnsiScreen screen{sink, this};
+    bool screen_active = false;
+    termios saved_input = {};
+    bool raw = false;
+
+    static volatile sig_atomic_t& resized() {
+        static volatile sig_atomic_t flag = 0;
+        return flag;
+    }
+
+    static void on_resize(int) { resized() = 1; }
+
+    static void sink(void* context, void* data, int size) {
+        static_cast<PosixConsole*>(context)->write_all(static_cast<const char*>(data), size);
+    }
+
+    static byte nearest_basic(const RGBA& c) {
+        const RGBA* basic = default_console_palette();
+        int best = 0, best_distance = INT32_MAX;
+        for(int i = 0; i < 16; i++) {
+            int dr = c.r - basic[i].r, dg = c.g - basic[i].g, db = c.b - basic[i].b;
+            int distance = dr * dr + dg * dg + db * db;
+            if(distance < best_distance) {
+                best = i;
+                best_distance = distance;
+            }
+        }
+        return static_cast<byte>(best);
+    }
+
+    // Attributes as sent: where a palette can only be approximated, its
+    // entries become the nearest of the terminal's 16 colors. Its own colors
+    // stay as they are.
+    const CellAttr* shown_attrs(const CellAttr* attrs, size_t cells) {
+        if(!approximated) return attrs;
+        auto shown = [this](byte color) { return color == CELL_DEFAULT_COLOR ? color : nearest[color]; };
+        remapped.resize(cells);
+        for(size_t i = 0; i < cells; i++) remapped[i] = cell_attr(shown(attr_fg(attrs[i])), shown(attr_bg(attrs[i])));
+        return remapped.data();
+    }
+
+    bool write_all(const char* data, size_t size) {
+        while(size) {
+            ssize_t written = write(STDOUT_FILENO, data, size);
+            if(written < 0 && errno == EINTR) continue;
+            if(written <= 0) return ok = false;
+            data += written;
+            size -= size_t(written);
+        }
+        return ok;
+    }
+
+    // Keys arrive one at a time and unechoed while events are read.
+    void raw_input() {
+        if(raw || !isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &saved_input) != 0) return;
+        termios settings = saved_input;
+        settings.c_lflag &= ~(ICANON | ECHO);
+        settings.c_cc[VMIN] = 1;
+        settings.c_cc[VTIME] = 0;
+        raw = tcsetattr(STDIN_FILENO, TCSANOW, &settings) == 0;
+    }
+
+    void restore_input() {
+        if(raw) tcsetattr(STDIN_FILENO, TCSANOW, &saved_input);
+        raw = false;
+    }
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <conio.h>
+#include <vector>
+#include "console.hpp"
+#include "../winsole/winsole.hpp"
+
+// The Windows console through Winsole: frames are blitted, screen mode is
+// Winsole's double buffering and the palette is loaded into the console's
+// own color table. Keys come from conio; a resize is noticed by polling the
+// window size. A console that Winsole can open is a terminal whose palette
+// can be redefined, so every palette shows exactly through BASIC attributes
+// and VT color sequences are never needed.
+class WinsoleConsole : public ConsoleBackend {
+public:
+    bool init() override {
+        if(!winsole.init()) return false;
+        caps.tty = true;
+        caps.colors = ColorSupport::BASIC;
+        caps.palette = true;
+        last_size = size();
+        return true;
+    }
+
+    ConsoleSize size() const override {
+        CONSOLE_SCREEN_BUFFER_INFO info;
+        const SMALL_RECT& window = GetConsoleScreenBufferInfo(winsole.get_handle(), &info) ? info.srWindow : winsole.get_window();
+        return {window.Right - window.Left + 1, window.Bottom - window.Top + 1};
+    }
+
+    const TerminalCaps& capabilities() const override { return caps; }
+
+    CellAttr default_attr() const override {
+        return cell_attr(winsole.get_foreground(), winsole.get_background());
+    }
+
+    bool set_palette(const RGBA* palette) override {
+        COLORREF table[CONSOLE_COLORS];
+        for(size_t i = 0; i < CONSOLE_COLORS; i++)
+            table[i] = RGB(palette[i].r, palette[i].g, palette[i].b);
+        return winsole.set_palette(table, CONSOLE_COLORS);
+    }
+
+    bool write_text(const char* text, size_t length) override {
+        DWORD written;
+        return WriteConsoleA(winsole.get_handle(), text, static_cast<DWORD>(length), &written, nullptr);
+    }
+
+    bool write_frame(const char* glyphs, const CellAttr* attrs, int columns, int rows) override {
+        bool ok = winsole.blit(glyphs, native_attrs(attrs, size_t(columns) * rows), columns, rows);
+        return screen ? winsole.flip() && ok : ok;
+    }
+
+    bool enter_screen() override {
+        screen = winsole.double_buffer();
+        return screen;
+    }
+
+    void leave_screen() override {
+        winsole.single_buffer();
+        screen = false;
+    }
+
+    bool poll_event(ConsoleEvent& event, int timeout_ms) override {
+        for(int waited = 0; timeout_ms < 0 || waited <= timeout_ms; waited += POLL_MS) {
+            if(_kbhit()) {
+                event.type = ConsoleEvent::KEY;
+                event.key = _getch();
+                return true;
+            }
+            ConsoleSize now = size();
+            if(now.columns != last_size.columns || now.rows != last_size.rows) {
+                last_size = now;
+                event.type = ConsoleEvent::RESIZE;
+                event.size = now;
+                return true;
+            }
+            Sleep(POLL_MS);
+        }
+        return false;
+    }
+
+    Winsole& native() { return winsole; }
+
+private:
+    static constexpr int POLL_MS = 10;
+    Winsole winsole;
+    TerminalCaps caps;
+    bool screen = false;
+    ConsoleSize last_size;
+    std::vector<unsigned char> narrowed;
+
+    // The console's wAttributes for `attrs`: channels in the terminal's own
+    // color take the console's current one.
+    const unsigned char* native_attrs(const CellAttr* attrs, size_t cells) {
+        CellAttr base = default_attr();
+        narrowed.resize(cells);
+        for(size_t i = 0; i < cells; i++) {
+            CellAttr attr = attrs[i];
+            if(attr & CELL_DEFAULT_FG) attr = (attr & ~0x0F) | (base & 0x0F);
+            if(attr & CELL_DEFAULT_BG) attr = (attr & ~0xF0) | (base & 0xF0);
+            narrowed[i] = static_cast<unsigned char>(attr);
+        }
+        return narrowed.data();
+    }
+};
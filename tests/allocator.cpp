@@ -0,0 +1,54 @@
+// image_realloc through a ScratchArena: the newest block grows and shrinks
+// where it is while the chunk has room, anything else moves, and the
+// contents survive either way.
+
+#include "check.hpp"
+#include "../core/allocator.hpp"
+
+static bool filled(const void* p, size_t size, unsigned char value) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(p);
+    for(size_t i = 0; i < size; i++)
+        if(bytes[i] != value) return false;
+    return true;
+}
+
+int main() {
+    ScratchArena arena(1 << 16);
+    UseImageAllocator use_arena(&arena);
+
+    void* first = image_malloc(100);
+    memset(first, 1, 100);
+    void* grown = image_realloc(first, 4000);
+    CHECK(grown == first);
+    CHECK(filled(grown, 100, 1));
+    void* shrunk = image_realloc(grown, 50);
+    CHECK(shrunk == first);
+
+    // No longer the newest block: growing moves it, shrinking still does not.
+    void* second = image_malloc(64);
+    memset(second, 2, 64);
+    void* moved = image_realloc(shrunk, 200);
+    CHECK(moved != shrunk);
+    CHECK(filled(moved, 50, 1));
+    CHECK(filled(second, 64, 2));
+    CHECK(image_realloc(second, 32) == second);
+
+    // Past the end of the chunk the block moves out to malloc.
+    void* last = image_malloc(16);
+    memset(last, 3, 16);
+    void* outside = image_realloc(last, 1 << 17);
+    CHECK(outside != last);
+    CHECK(filled(outside, 16, 3));
+    image_free(outside);
+    image_free(moved);
+    arena.reset();
+    CHECK(arena.size() >= (1 << 17));
+
+    // After the reset the whole chunk is free again, and the first block
+    // grows right up to its end.
+    void* fresh = image_malloc(16);
+    CHECK(image_realloc(fresh, arena.size() - sizeof(ImageBlockHeader)) == fresh);
+    CHECK(image_realloc(fresh, arena.size()) != fresh);
+
+    return check_result("allocator");
+}
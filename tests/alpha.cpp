@@ -0,0 +1,71 @@
+// Over a transparent background only the visible half of an image counts:
+// the fully transparent half carries garbage RGB (bright red here) that must
+// not reach the tone histogram or the AUTO palette. Compositing over a color
+// rounds the same in the vector kernel as in scalar code.
+
+#include <vector>
+#include "check.hpp"
+#include "../core/alpha.hpp"
+#include "../core/palette.hpp"
+
+int main() {
+    const int width = 32, height = 8;
+    std::vector<byte> pixels(size_t(width) * height * 4);
+    for(int y = 0; y < height; y++)
+        for(int x = 0; x < width; x++) {
+            byte* p = &pixels[(size_t(y) * width + x) * 4];
+            bool shown = x >= width / 2;
+            byte grey = (x + y) % 2 ? 40 : 200;
+            p[0] = shown ? grey : 255;
+            p[1] = shown ? grey : 0;
+            p[2] = shown ? grey : 0;
+            p[3] = shown ? 255 : 0;
+        }
+
+    PixelPlanes planes;
+    planes.deinterleave(pixels.data(), width, height, 4, false);
+    Background background;
+    background.transparent = true;
+    std::vector<byte> opaque, lightness;
+    composite_lightness_plane(planes, background, opaque, lightness);
+    CHECK(opaque.size() == planes.pixel_count());
+    CHECK(!opaque[0] && opaque[width - 1]);
+
+    Histogram histogram = lightness_histogram(lightness.data(), lightness.size(), opaque.data());
+    uint64_t total = 0;
+    for(uint32_t n : histogram) total += n;
+    CHECK(total == planes.pixel_count() / 2);
+    CHECK(histogram[127] == 0 && histogram[40] + histogram[200] == total);
+    CHECK(lightness_histogram(lightness.data(), lightness.size())[127] == planes.pixel_count() / 2);
+
+    // Levels over the visible greys alone stretch 40..200 to the full range.
+    ToneCurve curve = tone_curve(Tone::LEVELS, lightness.data(), lightness.size(), opaque.data());
+    CHECK(curve[40] == 0 && curve[200] == 255);
+
+    Palette palette = adaptive_palette(planes, 16, opaque.data());
+    CHECK(palette.size() == 2);
+    for(size_t i = 0; i < palette.size(); i++)
+        CHECK(palette[i].r == palette[i].g && palette[i].g == palette[i].b);
+
+    // Nothing visible: no palette at all rather than one from hidden pixels.
+    std::vector<byte> hidden(planes.pixel_count(), 0);
+    CHECK(adaptive_palette(planes, 16, hidden.data()).size() == 0);
+
+    // The 16-lane composite matches the scalar rounding for every pixel and
+    // alpha, including the tail past the last full step.
+    for(byte back : {byte(0), byte(77), byte(255)})
+        for(int value = 0; value < 256; value++) {
+            alignas(16) byte row[272], alpha[272];
+            for(int x = 0; x < 263; x++) {
+                row[x] = static_cast<byte>(value);
+                alpha[x] = static_cast<byte>(x);
+            }
+            composite_row(row, alpha, back, 263);
+            bool exact = true;
+            for(int x = 0; x < 263; x++)
+                exact &= row[x] == div255(value * uint32_t(alpha[x]) + back * uint32_t(255 - alpha[x]));
+            CHECK(exact);
+        }
+
+    return check_result("alpha");
+}
@@ -0,0 +1,66 @@
+// SGR sequences for packed cells: a channel left in the terminal's own color
+// survives packing and is sent as 39/49 in every encoding, never as the
+// palette entry whose index it happens to sit next to. A row of maximal
+// sequences fits the buffer export_ansi sizes for it.
+
+#include <string>
+#include <vector>
+#include "check.hpp"
+#include "../core/ansi.hpp"
+
+static std::string sgr(byte f, byte b, const RGBA* palette, ColorSupport colors) {
+    char buffer[SGR_MAX];
+    return std::string(buffer, write_sgr(buffer, f, b, palette, colors));
+}
+
+static void append(void* context, void* data, int size) {
+    static_cast<std::string*>(context)->append(static_cast<const char*>(data), size);
+}
+
+int main() {
+    const RGBA palette[16] = {};
+
+    CellAttr both = cell_attr(CELL_DEFAULT_COLOR, CELL_DEFAULT_COLOR);
+    CHECK(attr_fg(both) == CELL_DEFAULT_COLOR && attr_bg(both) == CELL_DEFAULT_COLOR);
+    CellAttr fg_only = cell_attr(attr_fg(both), 4);
+    CHECK(attr_fg(fg_only) == CELL_DEFAULT_COLOR && attr_bg(fg_only) == 4);
+    CHECK(cell_attr(7, 0) != cell_attr(7, CELL_DEFAULT_COLOR));
+    CHECK(cell_attr(15, 1) == 0x1F);
+
+    for(ColorSupport colors : {ColorSupport::BASIC, ColorSupport::XTERM256, ColorSupport::TRUECOLOR})
+        CHECK(sgr(CELL_DEFAULT_COLOR, CELL_DEFAULT_COLOR, palette, colors) == "\x1b[39;49m");
+    CHECK(sgr(CELL_DEFAULT_COLOR, 1, palette, ColorSupport::BASIC) == "\x1b[39;44m");
+    CHECK(sgr(15, CELL_DEFAULT_COLOR, palette, ColorSupport::BASIC) == "\x1b[97;49m");
+    CHECK(sgr(7, 0, palette, ColorSupport::BASIC) == "\x1b[37;40m");
+    CHECK(sgr(CELL_DEFAULT_COLOR, 0, palette, ColorSupport::TRUECOLOR) == "\x1b[39;48;2;0;0;0m");
+
+    const char glyphs[] = "ab";
+    const byte fg[] = {CELL_DEFAULT_COLOR, 12}, bg[] = {CELL_DEFAULT_COLOR, CELL_DEFAULT_COLOR};
+    std::string out;
+    export_ansi(glyphs, 2, 2, 1, fg, bg, palette, ColorSupport::BASIC, append, &out);
+    CHECK(out == "\x1b[39;49ma\x1b[91;49mb\x1b[0m\n");
+
+    // The worst case export_ansi sizes its row for: a full truecolor
+    // sequence before every cell, here with palette entries that need every
+    // digit.
+    {
+        const int columns = 33;
+        RGBA wide[16];
+        for(int i = 0; i < 16; i++) wide[i] = {255, 255, static_cast<byte>(200 + i)};
+        std::string row(columns, '#'), expected;
+        std::vector<byte> f(columns), b(columns);
+        for(int x = 0; x < columns; x++) {
+            f[x] = static_cast<byte>(x % 16);
+            b[x] = static_cast<byte>((x + 1) % 16);
+            std::string sequence = sgr(f[x], b[x], wide, ColorSupport::TRUECOLOR);
+            CHECK(sequence.size() == SGR_MAX);
+            expected += sequence + '#';
+        }
+        expected += SGR_ROW_END;
+        out.clear();
+        export_ansi(row.data(), columns, columns, 1, f.data(), b.data(), wide, ColorSupport::TRUECOLOR, append, &out);
+        CHECK(out == expected);
+    }
+
+    return check_result("ansi");
+}
@@ -0,0 +1,80 @@
+// Winsole's text attribute cache and print_runs against the console mock:
+// how many SetConsoleTextAttribute calls a grid takes, and that switching
+// screen buffers forgets the cached attribute.
+
+#include <string>
+#include <vector>
+#include "check.hpp"
+#include "../winsole/console_mock.hpp"
+#include "../winsole/winsole.hpp"
+
+int main() {
+    MockConsole& console = mock_console();
+    console.resize(80, 25);
+    console.attribute = 0x07;
+    Winsole winsole;
+    CHECK(winsole.init());
+
+    const size_t cells = 80 * 25;
+    std::string glyphs(cells, '#');
+
+    // One color over the whole grid: one change, one write, one restore.
+    std::vector<unsigned char> uniform(cells, 0x1E);
+    console.reset_calls();
+    CHECK(winsole.print_runs(glyphs.data(), uniform.data(), cells));
+    CHECK(console.calls.set_text_attribute == 2);
+    CHECK(console.calls.write_console == 1);
+    CHECK(console.attribute == 0x07);
+
+    // Inside a batch the restore waits for end_batch(), and a second grid in
+    // the color already set changes nothing.
+    console.reset_calls();
+    winsole.begin_batch();
+    CHECK(winsole.print_runs(glyphs.data(), uniform.data(), cells));
+    CHECK(winsole.print_runs(glyphs.data(), uniform.data(), cells));
+    CHECK(console.calls.set_text_attribute == 1);
+    winsole.end_batch();
+    CHECK(console.calls.set_text_attribute == 2);
+    CHECK(console.attribute == 0x07);
+
+    // Alternating colors: every cell is a run of its own.
+    std::vector<unsigned char> alternating(cells);
+    for(size_t i = 0; i < cells; i++) alternating[i] = i % 2 ? 0x4F : 0x2A;
+    console.reset_calls();
+    winsole.begin_batch();
+    CHECK(winsole.print_runs(glyphs.data(), alternating.data(), cells));
+    winsole.end_batch();
+    CHECK(console.calls.set_text_attribute == cells + 1);
+    CHECK(console.calls.write_console == cells);
+
+    // Repeated colors hit the cache...
+    COLORS colors = {LIGHT_YELLOW, BLUE};
+    winsole.begin_batch();
+    console.reset_calls();
+    winsole.put('a', colors);
+    winsole.put('b', colors);
+    CHECK(console.calls.set_text_attribute == 1);
+
+    // ...until the buffer drawn into changes: each new buffer starts from
+    // its own attribute, so the same colors must be set again.
+    CHECK(winsole.double_buffer());
+    console.reset_calls();
+    winsole.put('c', colors);
+    winsole.put('d', colors);
+    CHECK(console.calls.set_text_attribute == 1);
+
+    CHECK(winsole.flip());
+    console.reset_calls();
+    winsole.put('e', colors);
+    winsole.put('f', colors);
+    CHECK(console.calls.set_text_attribute == 1);
+
+    winsole.single_buffer();
+    console.reset_calls();
+    winsole.put('g', colors);
+    winsole.put('h', colors);
+    CHECK(console.calls.set_text_attribute == 1);
+    winsole.end_batch();
+
+    return check_result("attributes");
+}
@@ -0,0 +1,136 @@
+// Winsole::blit against the console mock: how many WriteConsoleOutputA calls
+// a frame takes, that every cell lands where it belongs, that frames
+// reaching past the console are clipped to it, and that on a buffer with
+// scrollback frames follow the cursor like printed text.
+
+#include <string>
+#include <vector>
+#include "check.hpp"
+#include "../winsole/console_mock.hpp"
+#include "../winsole/winsole.hpp"
+
+struct Grid {
+    int columns, rows;
+    std::string glyphs;
+    std::vector<unsigned char> attrs;
+
+    Grid(int c, int r) : columns(c), rows(r), glyphs(size_t(c) * r, ' '), attrs(size_t(c) * r) {
+        for(size_t i = 0; i < glyphs.size(); i++) {
+            glyphs[i] = static_cast<char>('!' + i % 90);
+            attrs[i] = static_cast<unsigned char>(i * 7);
+        }
+    }
+
+    // The whole grid, its top row at `top`.
+    bool shown_at(const MockConsole& console, int top) const {
+        for(int y = 0; y < rows; y++)
+            for(int x = 0; x < columns; x++)
+                if(console.at(x, top + y).Char.AsciiChar != glyphs[size_t(y) * columns + x]) return false;
+        return true;
+    }
+
+    bool shown(const MockConsole& console, int width, int height) const {
+        for(int y = 0; y < height; y++)
+            for(int x = 0; x < width; x++) {
+                const CHAR_INFO& cell = console.at(x, y);
+                size_t i = size_t(y) * columns + x;
+                if(cell.Char.AsciiChar != glyphs[i] || cell.Attributes != attrs[i]) return false;
+            }
+        return true;
+    }
+};
+
+// Blits `grid` on a fresh width x height console; the number of
+// WriteConsoleOutputA calls it took.
+static size_t blit_calls(const Grid& grid, SHORT width, SHORT height) {
+    MockConsole& console = mock_console();
+    console.resize(width, height);
+    Winsole winsole;
+    CHECK(winsole.init());
+    console.reset_calls();
+    CHECK(winsole.blit(grid.glyphs.data(), grid.attrs.data(), grid.columns, grid.rows));
+    CHECK(grid.shown(console, grid.columns < width ? grid.columns : width, grid.rows < height ? grid.rows : height));
+    CHECK(console.offscreen_writes == 0);
+    return console.calls.write_output;
+}
+
+int main() {
+    // A console big enough for all of them: bands of whole rows, at most
+    // BLIT_MAX_CELLS cells each.
+    CHECK(blit_calls(Grid(80, 25), 20000, 100) == 1);
+    CHECK(blit_calls(Grid(300, 100), 20000, 100) == 2);
+    CHECK(blit_calls(Grid(20000, 3), 20000, 100) == 3);
+
+    // Larger than the console: only the visible part is sent, so the rows
+    // below it cost no calls, and nothing outside the screen is touched.
+    CHECK(blit_calls(Grid(300, 100), 120, 30) == 1);
+    CHECK(blit_calls(Grid(20000, 3), 120, 30) == 1);
+    CHECK(blit_calls(Grid(80, 25), 40, 10) == 1);
+    CHECK(blit_calls(Grid(40000, 2), 120, 30) == 2);
+
+    // At an offset, the region handed to the API already stops at the edges.
+    MockConsole& console = mock_console();
+    console.resize(120, 30);
+    console.reset_calls();
+    Grid grid(50, 20);
+    std::vector<CHAR_INFO> frame;
+    build_frame(grid.glyphs.data(), grid.attrs.data(), grid.columns, grid.rows, frame);
+    CHECK(blit_frame(&console, frame.data(), grid.columns, grid.rows, {100, 20}, {120, 30}));
+    CHECK(console.calls.write_output == 1 && console.offscreen_writes == 0);
+    bool placed = true;
+    for(int y = 0; y < 10; y++)
+        for(int x = 0; x < 20; x++)
+            placed = placed && console.at(100 + x, 20 + y).Char.AsciiChar == grid.glyphs[size_t(y) * grid.columns + x];
+    CHECK(placed);
+    CHECK(console.at(99, 20).Char.AsciiChar == 0 && console.at(100, 19).Char.AsciiChar == 0);
+    console.reset_calls();
+    CHECK(blit_frame(&console, frame.data(), grid.columns, grid.rows, {120, 0}, {120, 30}));
+    CHECK(console.calls.write_output == 0);
+
+    // A real console: 300 rows of scrollback behind a 30-row window, already
+    // scrolled. The frame goes where the cursor is, the cursor moves past it
+    // and the window follows.
+    console.resize(80, 300, 30);
+    Winsole winsole;
+    CHECK(winsole.init());
+    CHECK(winsole.get_window().Bottom - winsole.get_window().Top == 29);
+    SetConsoleCursorPosition(&console, {0, 120});
+    Grid small(10, 5);
+    CHECK(winsole.blit(small.glyphs.data(), small.attrs.data(), small.columns, small.rows));
+    CHECK(console.at(0, 120).Char.AsciiChar == small.glyphs[0]);
+    CHECK(console.at(9, 124).Char.AsciiChar == small.glyphs.back());
+    CHECK(console.at(0, 0).Char.AsciiChar == 0);
+    CHECK(console.cursor.X == 0 && console.cursor.Y == 125);
+    CHECK(console.window.Top <= 125 && console.window.Bottom >= 125);
+
+    // Mid-line text is kept: the frame starts on the next line.
+    WriteConsoleA(&console, "ab", 2, nullptr, nullptr);
+    CHECK(winsole.blit(small.glyphs.data(), small.attrs.data(), small.columns, small.rows));
+    CHECK(console.at(0, 125).Char.AsciiChar == 'a' && console.at(0, 126).Char.AsciiChar == small.glyphs[0]);
+    CHECK(console.cursor.Y == 131);
+
+    // Near the end of the buffer it scrolls up instead of cutting rows off.
+    SetConsoleCursorPosition(&console, {0, 297});
+    CHECK(winsole.blit(small.glyphs.data(), small.attrs.data(), small.columns, small.rows));
+    CHECK(small.shown_at(console, 294));
+    CHECK(console.cursor.Y == 299);
+
+    // Loading a palette writes the buffer info back: the scrollback and the
+    // cursor must survive it.
+    COLORREF table[CONSOLE_COLORS] = {};
+    CHECK(winsole.set_palette(table, CONSOLE_COLORS));
+    CHECK(console.width == 80 && console.height == 300);
+    CHECK(console.cursor.Y == 299);
+
+    // In screen mode every frame fills the window and the cursor stays put.
+    CHECK(winsole.double_buffer());
+    COORD cursor = console.cursor;
+    SHORT window_top = console.window.Top;
+    CHECK(winsole.blit(small.glyphs.data(), small.attrs.data(), small.columns, small.rows));
+    CHECK(winsole.blit(small.glyphs.data(), small.attrs.data(), small.columns, small.rows));
+    CHECK(small.shown_at(console, window_top));
+    CHECK(console.cursor.X == cursor.X && console.cursor.Y == cursor.Y);
+    winsole.single_buffer();
+
+    return check_result("blit");
+}
@@ -0,0 +1,78 @@
+// write_file_atomic: replaces in place, leaves no temporary files behind,
+// and concurrent writers of the same path each land a whole file.
+// CachePruner: rescans the cache only when it could have outgrown its limit.
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+#include "../core/cache.hpp"
+
+namespace fs = std::filesystem;
+
+static size_t temp_files(const fs::path& dir) {
+    size_t count = 0;
+    for(const auto& file : fs::directory_iterator(dir))
+        count += file.path().filename().string().find(CACHE_TEMP_SUFFIX) != std::string::npos;
+    return count;
+}
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / ("asciimage-cache-test-" + std::to_string(getpid()));
+    fs::create_directories(dir);
+    std::string path = (dir / "entry.asf").string();
+
+    std::vector<unsigned char> bytes;
+    CHECK(write_file_atomic(path, "first", 5));
+    CHECK(read_file(path, bytes) && std::string(bytes.begin(), bytes.end()) == "first");
+    CHECK(write_file_atomic(path, "second!", 7));
+    CHECK(read_file(path, bytes) && std::string(bytes.begin(), bytes.end()) == "second!");
+    CHECK(temp_files(dir) == 0);
+
+    // Each writer's content is distinct and a whole file; whatever wins, the
+    // entry must be one of them, never a mix or a missing file.
+    const int writers = 4, rounds = 200;
+    const size_t length = 4096;
+    std::vector<std::thread> threads;
+    std::atomic<int> failed{0};
+    for(int w = 0; w < writers; w++) {
+        threads.emplace_back([&, w] {
+            std::string content(length, static_cast<char>('a' + w));
+            for(int i = 0; i < rounds; i++)
+                if(!write_file_atomic(path, content.data(), content.size())) failed++;
+        });
+    }
+    for(std::thread& thread : threads) thread.join();
+    CHECK(failed == 0);
+    CHECK(read_file(path, bytes) && bytes.size() == length);
+    CHECK(bytes.size() == length && std::count(bytes.begin(), bytes.end(), bytes[0]) == static_cast<long>(length));
+    CHECK(temp_files(dir) == 0);
+
+    // CachePruner scans once up front, then only when the stores it was told
+    // about could have passed the limit: a file it never heard of goes
+    // unnoticed until then, and is evicted oldest first once it is.
+    setenv("ASCIIMAGE_CACHE", dir.string().c_str(), 1);
+    auto store = [&](const char* name, size_t size, int age) {
+        std::string content(size, 'x');
+        std::string file = cache_path(std::string("prune-") + name);
+        CHECK(write_file_atomic(file, content.data(), content.size()));
+        fs::last_write_time(file, fs::file_time_type::clock::now() - std::chrono::hours(age));
+        return file;
+    };
+    CachePruner pruner("prune-", 3000);
+    std::string first = store("a", 1000, 4);
+    pruner.stored(1000);
+    std::string unseen = store("unseen", 5000, 3);
+    std::string second = store("b", 1000, 2);
+    pruner.stored(1000);
+    CHECK(fs::exists(first) && fs::exists(unseen) && fs::exists(second));
+    std::string third = store("c", 1500, 1);
+    pruner.stored(1500);
+    CHECK(!fs::exists(first) && !fs::exists(unseen));
+    CHECK(fs::exists(second) && fs::exists(third));
+
+    std::error_code error;
+    fs::remove_all(dir, error);
+    return check_result("cache");
+}
@@ -0,0 +1,59 @@
+// Packed console cells: every fg/bg pair survives cell_attr, runs of equal
+// attributes end where they should, a reused CellGrid keeps its storage, and
+// a cached .asf frame unpacks into the same glyphs and attributes it was
+// made from, default colors included.
+
+#include <string>
+#include <vector>
+#include "check.hpp"
+#include "../core/cells.hpp"
+#include "../core/frame.hpp"
+
+int main() {
+    bool packed = true;
+    for(int f = 0; f < 16; f++)
+        for(int b = 0; b < 16; b++) {
+            CellAttr attr = cell_attr(static_cast<byte>(f), static_cast<byte>(b));
+            packed &= attr_fg(attr) == f && attr_bg(attr) == b && attr == (f | b << 4);
+        }
+    CHECK(packed);
+
+    const CellAttr row[] = {cell_attr(1, 0), cell_attr(1, 0), cell_attr(2, 0), cell_attr(2, CELL_DEFAULT_COLOR), cell_attr(2, CELL_DEFAULT_COLOR)};
+    CHECK(attr_run(row, 0, 5) == 2);
+    CHECK(attr_run(row, 2, 5) == 3);
+    CHECK(attr_run(row, 3, 5) == 5);
+    CHECK(attr_run(row, 0, 1) == 1);
+
+    CellGrid grid;
+    grid.resize(80, 25);
+    const char* glyphs = grid.glyphs.data();
+    const CellAttr* attrs = grid.attrs.data();
+    grid.resize(40, 10);
+    CHECK(grid.cells() == 400 && grid.glyphs.data() == glyphs && grid.attrs.data() == attrs);
+    CHECK(grid.glyph_row(3) == glyphs + 120 && grid.attr_row(3) == attrs + 120);
+
+    // A frame as the render cache stores it, glyph rows padded to a stride
+    // (the newline of text output), replayed into cells.
+    const int columns = 6, rows = 3;
+    std::string text = "abcdef\nghijkl\nmnopqr";
+    std::vector<byte> fg(columns * rows), bg(columns * rows);
+    for(int i = 0; i < columns * rows; i++) {
+        fg[i] = static_cast<byte>(i % 16);
+        bg[i] = i % 5 ? static_cast<byte>(15 - i % 16) : FRAME_DEFAULT_COLOR;
+    }
+    RGBA palette[FRAME_PALETTE] = {};
+    std::vector<byte> bytes;
+    encode_frame(text.data(), columns + 1, columns, rows, fg.data(), bg.data(), palette, true, bytes);
+    Frame frame;
+    CHECK(frame.parse(bytes.data(), bytes.size()));
+    grid.assign(frame.glyphs, frame.columns, frame.columns, frame.rows, frame.fg, frame.bg);
+    CHECK(grid.columns == columns && grid.rows == rows);
+    CHECK(std::string(grid.glyph_row(1), columns) == "ghijkl" && std::string(grid.glyph_row(2), columns) == "mnopqr");
+    bool replayed = true;
+    for(int i = 0; i < columns * rows; i++)
+        replayed &= attr_fg(grid.attrs[i]) == fg[i] && attr_bg(grid.attrs[i]) == bg[i];
+    CHECK(replayed);
+    CHECK(grid.attrs[0] & CELL_DEFAULT_BG && !(grid.attrs[1] & CELL_DEFAULT_BG));
+
+    return check_result("cells");
+}
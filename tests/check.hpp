@@ -0,0 +1,26 @@
+#pragma once
+
+// Just enough of a test harness for the header-only core: CHECK reports a
+// failed condition with its location and keeps going, and check_result()
+// turns the count into the exit code ctest looks at.
+
+#include <cstdio>
+
+inline int& check_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition) \
+    do { \
+        if(!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            check_failures()++; \
+        } \
+    } while(0)
+
+inline int check_result(const char* name) {
+    if(check_failures()) fprintf(stderr, "[%s] %d check(s) failed\n", name, check_failures());
+    else printf("[%s] ok\n", name);
+    return check_failures() ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+// wait_key through a scripted ConsoleBackend: every resize redraws the grid
+// it was given, a key ends the wait, and so does input that is gone for good.
+
+#include <deque>
+#include <string>
+#include "check.hpp"
+#include "../platform/console.hpp"
+
+// Hands out a fixed list of events, then reports no more input; records the
+// frames it is asked to draw.
+class ScriptedConsole : public ConsoleBackend {
+public:
+    std::deque<ConsoleEvent> events;
+    size_t frames = 0;
+    std::string last_glyphs;
+    int last_columns = 0, last_rows = 0;
+
+    bool init() override { return true; }
+    ConsoleSize size() const override { return {80, 25}; }
+    const TerminalCaps& capabilities() const override { return caps; }
+    CellAttr default_attr() const override { return cell_attr(7, 0); }
+    bool set_palette(const RGBA*) override { return true; }
+    bool write_text(const char*, size_t) override { return true; }
+
+    bool write_frame(const char* glyphs, const CellAttr*, int columns, int rows) override {
+        frames++;
+        last_glyphs.assign(glyphs, size_t(columns) * rows);
+        last_columns = columns;
+        last_rows = rows;
+        return true;
+    }
+
+    bool enter_screen() override { return true; }
+    void leave_screen() override {}
+
+    bool poll_event(ConsoleEvent& event, int) override {
+        if(events.empty()) return false;
+        event = events.front();
+        events.pop_front();
+        return true;
+    }
+
+private:
+    TerminalCaps caps;
+};
+
+static ConsoleEvent resize(int columns, int rows) {
+    ConsoleEvent event;
+    event.type = ConsoleEvent::RESIZE;
+    event.size = {columns, rows};
+    return event;
+}
+
+static ConsoleEvent key(int code) {
+    ConsoleEvent event;
+    event.type = ConsoleEvent::KEY;
+    event.key = code;
+    return event;
+}
+
+int main() {
+    CellGrid cells;
+    cells.resize(4, 2);
+    for(size_t i = 0; i < cells.cells(); i++) {
+        cells.glyphs[i] = static_cast<char>('a' + i);
+        cells.attrs[i] = cell_attr(static_cast<byte>(i), 0);
+    }
+
+    // Two resizes redraw twice; the key stops the wait before the last one.
+    ScriptedConsole console;
+    console.events = {resize(100, 30), resize(60, 20), key('q'), resize(80, 25)};
+    wait_key(console, &cells);
+    CHECK(console.frames == 2);
+    CHECK(console.last_columns == 4 && console.last_rows == 2);
+    CHECK(console.last_glyphs == "abcdefgh");
+    CHECK(console.events.size() == 1);
+
+    // Nothing to redraw: resizes pass by.
+    ScriptedConsole bare;
+    bare.events = {resize(100, 30), key(' ')};
+    wait_key(bare);
+    CHECK(bare.frames == 0 && bare.events.empty());
+
+    // Input closed before any key: the wait ends instead of spinning.
+    ScriptedConsole closed;
+    closed.events = {resize(100, 30)};
+    wait_key(closed, &cells);
+    CHECK(closed.frames == 1);
+
+    return check_result("console");
+}
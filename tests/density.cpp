@@ -0,0 +1,58 @@
+// density_ascii_image sizes its text exactly: width glyphs and a newline per
+// row, none after the last, spaces where `opaque` hides a pixel, and the
+// same text whether the rows are written on one thread or in bands.
+
+#include <array>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "check.hpp"
+#include "../core/density.hpp"
+
+static std::string reference(const std::vector<byte>& lightness, const byte* opaque, int width, int height, const std::array<char, 256>& glyphs) {
+    std::string text;
+    for(int y = 0; y < height; y++) {
+        if(y) text += '\n';
+        for(int x = 0; x < width; x++) {
+            size_t i = size_t(y) * width + x;
+            text += (!opaque || opaque[i]) ? glyphs[lightness[i]] : ' ';
+        }
+    }
+    return text;
+}
+
+int main() {
+    std::array<char, 256> glyphs;
+    for(size_t v = 0; v < 256; v++) glyphs[v] = static_cast<char>('A' + v % 26);
+
+    std::string text;
+    std::vector<byte> tiny = {0, 1, 2, 3, 4, 5};
+    density_ascii_image(tiny.data(), nullptr, 3, 2, glyphs, text);
+    CHECK(text == "ABC\nDEF");
+    const byte opaque[] = {1, 0, 1, 1, 1, 0};
+    density_ascii_image(tiny.data(), opaque, 3, 2, glyphs, text);
+    CHECK(text == "A C\nDE ");
+    density_ascii_image(tiny.data(), nullptr, 1, 1, glyphs, text);
+    CHECK(text == "A");
+    density_ascii_image(tiny.data(), nullptr, 0, 2, glyphs, text);
+    CHECK(text.empty());
+
+    // Large enough for several bands; the buffer is reused, not reallocated,
+    // once it has held the largest image.
+    const int width = 1021, height = 1031;
+    std::vector<byte> lightness(size_t(width) * height), mask(lightness.size());
+    for(size_t i = 0; i < lightness.size(); i++) {
+        lightness[i] = static_cast<byte>(rand());
+        mask[i] = static_cast<byte>(rand() % 4 != 0);
+    }
+    density_ascii_image(lightness.data(), nullptr, width, height, glyphs, text);
+    CHECK(text.size() == size_t(width + 1) * height - 1);
+    CHECK(text == reference(lightness, nullptr, width, height, glyphs));
+    const char* storage = text.data();
+    density_ascii_image(lightness.data(), mask.data(), width, height, glyphs, text);
+    CHECK(text == reference(lightness, mask.data(), width, height, glyphs));
+    density_ascii_image(lightness.data(), mask.data(), 64, 64, glyphs, text);
+    CHECK(text.data() == storage && text.size() == 65 * 64 - 1);
+
+    return check_result("density");
+}
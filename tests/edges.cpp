@@ -0,0 +1,48 @@
+// The Sobel overlay picks the line glyph that runs along an edge: a vertical
+// step in a 3x3 image draws '|', a horizontal one '-', a diagonal '/' or
+// '\'; flat areas keep their density glyph and hidden cells stay blank. The
+// vector row pass matches the scalar sums across odd widths.
+
+#include <array>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "check.hpp"
+#include "../core/edges.hpp"
+
+static char center(const std::vector<byte>& pixels, const std::vector<byte>& opaque = {}) {
+    std::array<char, 256> glyphs;
+    glyphs.fill('.');
+    return edge_ascii_image(pixels.data(), 3, 3, glyphs, opaque, DEFAULT_EDGE_THRESHOLD)[5];
+}
+
+int main() {
+    CHECK(center({0, 255, 255, 0, 255, 255, 0, 255, 255}) == '|');
+    CHECK(center({0, 0, 0, 255, 255, 255, 255, 255, 255}) == '-');
+    CHECK(center({255, 255, 255, 255, 255, 255, 0, 0, 0}) == '_');
+    CHECK(center({0, 0, 255, 0, 255, 255, 255, 255, 255}) == '/');
+    CHECK(center({255, 0, 0, 255, 255, 0, 255, 255, 255}) == '\\');
+    CHECK(center(std::vector<byte>(9, 128)) == '.');
+
+    std::vector<byte> opaque(9, 1);
+    opaque[4] = 0;
+    CHECK(center({0, 255, 255, 0, 255, 255, 0, 255, 255}, opaque) == ' ');
+
+    std::string text = edge_ascii_image(std::vector<byte>(9, 0).data(), 3, 3, {}, {}, DEFAULT_EDGE_THRESHOLD);
+    CHECK(text.size() == 11 && text[3] == '\n' && text[7] == '\n');
+
+    for(int width : {1, 7, 8, 9, 31}) {
+        std::vector<int16_t> rows(size_t(width) * 5), gx(width), gy(width);
+        for(int16_t& v : rows) v = static_cast<int16_t>(rand() % 2041 - 1020);
+        const int16_t* r = rows.data();
+        sobel_row(r, r + width, r + 2 * width, r + 3 * width, r + 4 * width, gx.data(), gy.data(), width);
+        bool exact = true;
+        for(int x = 0; x < width; x++) {
+            exact &= gx[x] == int16_t(r[x] + 2 * r[width + x] + r[2 * width + x]);
+            exact &= gy[x] == int16_t(r[4 * width + x] - r[3 * width + x]);
+        }
+        CHECK(exact);
+    }
+
+    return check_result("edges");
+}
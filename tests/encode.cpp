@@ -0,0 +1,99 @@
+// The format-aware encoder: extensions pick the format (PNG otherwise), every
+// format decodes back to the pixels it was given (JPEG to the right size),
+// a file written through FileSink matches the in-memory encoding, and stage
+// dumps land at <prefix>-<stage><ext>.
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "check.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "../core/image.hpp"
+#include "../core/png.hpp"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STBIW_ZLIB_COMPRESS png_deflate
+#include "../core/encode.hpp"
+
+namespace fs = std::filesystem;
+
+static std::vector<unsigned char> read_all(const std::string& path) {
+    std::vector<unsigned char> bytes;
+    if(FILE* file = fopen(path.c_str(), "rb")) {
+        unsigned char chunk[4096];
+        for(size_t n; (n = fread(chunk, 1, sizeof(chunk), file)) > 0;) bytes.insert(bytes.end(), chunk, chunk + n);
+        fclose(file);
+    }
+    return bytes;
+}
+
+int main() {
+    CHECK(format_from_path("out.JPG") == ImageFormat::JPG);
+    CHECK(format_from_path("out.jpeg") == ImageFormat::JPG);
+    CHECK(format_from_path("dir/out.bmp") == ImageFormat::BMP);
+    CHECK(format_from_path("out.tga") == ImageFormat::TGA);
+    CHECK(format_from_path("out.webp") == ImageFormat::PNG);
+    CHECK(format_from_path("dir.jpg/out") == ImageFormat::PNG);
+    CHECK(format_from_path("out.auto") == ImageFormat::PNG);
+    ImageFormat format;
+    CHECK(parse_image_format("JPEG", format) && format == ImageFormat::JPG && !parse_image_format("gif", format));
+
+    const int width = 37, height = 23, channels = 3;
+    std::vector<unsigned char> pixels(size_t(width) * height * channels);
+    for(size_t i = 0; i < pixels.size(); i++) pixels[i] = static_cast<unsigned char>(i * 7 + i / 97);
+
+    MemorySink sink;
+    for(ImageFormat lossless : {ImageFormat::PNG, ImageFormat::BMP, ImageFormat::TGA}) {
+        EncodeOptions options;
+        options.format = lossless;
+        CHECK(encode_image(sink, width, height, channels, pixels.data(), options));
+        int w, h, comp;
+        unsigned char* decoded = stbi_load_from_memory(sink.bytes.data(), static_cast<int>(sink.bytes.size()), &w, &h, &comp, channels);
+        CHECK(decoded && w == width && h == height);
+        CHECK(decoded && memcmp(decoded, pixels.data(), pixels.size()) == 0);
+        stbi_image_free(decoded);
+    }
+
+    EncodeOptions jpg;
+    jpg.format = ImageFormat::JPG;
+    CHECK(encode_image(sink, width, height, channels, pixels.data(), jpg));
+    CHECK(sink.bytes.size() > 2 && sink.bytes[0] == 0xFF && sink.bytes[1] == 0xD8);
+    int w = 0, h = 0, comp = 0;
+    CHECK(stbi_info_from_memory(sink.bytes.data(), static_cast<int>(sink.bytes.size()), &w, &h, &comp) && w == width && h == height);
+
+    fs::path dir = fs::temp_directory_path() / ("asciimage-encode-test-" + std::to_string(getpid()));
+    fs::create_directories(dir);
+
+    // A file written by extension is the same bytes as the PNG encoded in
+    // memory, whatever size the FileSink buffer flushes at.
+    EncodeOptions png;
+    png.format = ImageFormat::PNG;
+    CHECK(encode_image(sink, width, height, channels, pixels.data(), png));
+    std::string path = (dir / "out.png").string();
+    CHECK(write_image(path, width, height, channels, pixels.data(), EncodeOptions()));
+    CHECK(read_all(path) == sink.bytes);
+
+    std::string small_path = (dir / "small.bin").string();
+    FILE* file = fopen(small_path.c_str(), "wb");
+    CHECK(file);
+    if(file) {
+        FileSink small(file, 64);
+        for(size_t offset = 0; offset < sink.bytes.size(); offset += 50)
+            small.write(sink.bytes.data() + offset, std::min<size_t>(50, sink.bytes.size() - offset));
+        small.write(sink.bytes.data(), 0);
+        small.flush();
+        CHECK(small.ok && fclose(file) == 0);
+        CHECK(read_all(small_path) == sink.bytes);
+    }
+    CHECK(!write_image((dir / "missing" / "out.png").string(), width, height, channels, pixels.data(), EncodeOptions()));
+
+    StageWriter stages;
+    CHECK(!stages.enabled() && stages.write("input", width, height, channels, pixels.data()));
+    stages.prefix = (dir / "run").string();
+    stages.options.format = ImageFormat::BMP;
+    CHECK(stages.write("lightness", width, height, channels, pixels.data()));
+    CHECK(fs::exists(dir / "run-lightness.bmp"));
+
+    fs::remove_all(dir);
+    return check_result("encode");
+}
@@ -0,0 +1,53 @@
+// The exact matcher's SSD kernel against a scalar sum, and the atlas
+// normalization shared with ShapeMatcher: the densest region of the set
+// reads as full ink, and a cell that is a glyph's own tile picks that glyph.
+
+#include <random>
+#include "check.hpp"
+#include "../core/exact.hpp"
+
+int main() {
+    std::mt19937 random(33);
+
+    for(int round = 0; round < 1000; round++) {
+        Tile a, b;
+        for(int i = 0; i < TILE_SIZE; i++) {
+            a.pixels[i] = static_cast<byte>(random());
+            b.pixels[i] = static_cast<byte>(random());
+        }
+        uint32_t expected = 0;
+        for(int i = 0; i < TILE_SIZE; i++) expected += (a.pixels[i] - b.pixels[i]) * (a.pixels[i] - b.pixels[i]);
+        CHECK(tile_ssd(a, b, UINT32_MAX) == expected);
+        CHECK(tile_ssd(a, b, 0) <= expected); // early out returns the first half only
+    }
+
+    // Sparse glyphs at most half inked, so normalization has work to do.
+    GlyphSet set;
+    set.cell_width = TILE_WIDTH;
+    set.cell_height = TILE_HEIGHT;
+    for(char c = 'A'; c <= 'Z'; c++) set.glyphs += c;
+    set.bitmaps.assign(set.glyphs.size() * set.cell_size(), 0);
+    for(byte& v : set.bitmaps) v = random() % 4 == 0 ? 128 : 0;
+
+    float densest = 0.0f;
+    for(size_t i = 0; i < set.glyphs.size(); i++)
+        for(float f : glyph_features(set, i)) densest = std::max(densest, f);
+    GlyphAtlas atlas = build_atlas(set);
+    CHECK(atlas.tiles.size() == set.glyphs.size());
+    byte brightest = 0;
+    for(const Tile& tile : atlas.tiles)
+        for(byte v : tile.pixels) brightest = std::max(brightest, v);
+    CHECK(brightest == static_cast<byte>(std::min(255.0f, 128.0f / densest + 0.5f)));
+
+    // An image made of the atlas tiles themselves, one glyph per cell: cells
+    // are square, so each tile column is doubled to TILE_HEIGHT wide.
+    const int columns = static_cast<int>(set.glyphs.size());
+    std::vector<byte> square(size_t(columns) * TILE_HEIGHT * TILE_HEIGHT, 0);
+    for(int g = 0; g < columns; g++)
+        for(int y = 0; y < TILE_HEIGHT; y++)
+            for(int x = 0; x < TILE_HEIGHT; x++)
+                square[size_t(y) * columns * TILE_HEIGHT + g * TILE_HEIGHT + x] = atlas.tiles[g].pixels[y * TILE_WIDTH + x / 2];
+    std::string output = exact_ascii_image(square.data(), columns * TILE_HEIGHT, TILE_HEIGHT, TILE_HEIGHT, atlas, identity_curve());
+    CHECK(output == set.glyphs);
+    return check_result("exact");
+}
@@ -0,0 +1,112 @@
+// Frame::parse reads back what encode_frame writes, raw and RLE, keeps cells
+// in the console's default colors resolvable, and turns away colors outside
+// the palette and headers whose cell count the payload could never fill
+// before it allocates anything for them.
+
+#include <string>
+#include "check.hpp"
+#include "../core/frame.hpp"
+
+static FrameHeader header_of(const std::vector<byte>& bytes) {
+    FrameHeader header;
+    memcpy(&header, bytes.data(), sizeof(header));
+    return header;
+}
+
+static void set_header(std::vector<byte>& bytes, const FrameHeader& header) {
+    memcpy(bytes.data(), &header, sizeof(header));
+}
+
+int main() {
+    const int columns = 40, rows = 12;
+    std::string glyphs(size_t(columns) * rows, ' ');
+    std::vector<byte> fg(glyphs.size(), 7), bg(glyphs.size(), 0);
+    for(size_t i = 0; i < glyphs.size(); i++) {
+        glyphs[i] = static_cast<char>('!' + i % 90);
+        if(i % 3 == 0) fg[i] = static_cast<byte>(i % 16);
+    }
+    RGBA palette[FRAME_PALETTE] = {};
+
+    for(bool rle : {false, true}) {
+        std::vector<byte> bytes;
+        encode_frame(glyphs.data(), columns, columns, rows, fg.data(), bg.data(), palette, rle, bytes);
+        Frame frame;
+        CHECK(frame.parse(bytes.data(), bytes.size()));
+        CHECK(frame.columns == columns && frame.rows == rows);
+        CHECK(memcmp(frame.glyphs, glyphs.data(), glyphs.size()) == 0);
+        CHECK(memcmp(frame.fg, fg.data(), fg.size()) == 0);
+        CHECK(memcmp(frame.bg, bg.data(), bg.size()) == 0);
+        CHECK(!frame.parse(bytes.data(), bytes.size() - 1));
+    }
+
+    // Default colors survive the round trip and resolve to whatever the
+    // console's are; version 1 frames, which never held them, may not.
+    {
+        std::vector<byte> plane = fg;
+        plane[0] = plane[5] = FRAME_DEFAULT_COLOR;
+        std::vector<byte> bytes, resolved;
+        encode_frame(glyphs.data(), columns, columns, rows, plane.data(), bg.data(), palette, true, bytes);
+        Frame frame;
+        CHECK(frame.parse(bytes.data(), bytes.size()));
+        resolve_default_color(frame.fg, frame.cells(), 9, resolved);
+        CHECK(resolved.size() == plane.size() && resolved[0] == 9 && resolved[5] == 9);
+        CHECK(resolved[1] == fg[1] && resolved[3] == fg[3]);
+
+        FrameHeader old = header_of(bytes);
+        old.version = 1;
+        set_header(bytes, old);
+        CHECK(!frame.parse(bytes.data(), bytes.size()));
+        old.version = FRAME_VERSION + 1;
+        set_header(bytes, old);
+        CHECK(!frame.parse(bytes.data(), bytes.size()));
+
+        std::vector<byte> plain;
+        encode_frame(glyphs.data(), columns, columns, rows, fg.data(), bg.data(), palette, true, plain);
+        old = header_of(plain);
+        old.version = 1;
+        set_header(plain, old);
+        CHECK(frame.parse(plain.data(), plain.size()));
+    }
+
+    // Colors past the palette would be read out of its bounds when drawn.
+    for(bool rle : {false, true})
+        for(byte color : {byte(16), byte(200), byte(254)}) {
+            std::vector<byte> bad_fg = fg, bad_bg = bg, bytes;
+            bad_fg[7] = color;
+            encode_frame(glyphs.data(), columns, columns, rows, bad_fg.data(), bg.data(), palette, rle, bytes);
+            Frame frame;
+            CHECK(!frame.parse(bytes.data(), bytes.size()));
+            bad_bg[glyphs.size() - 1] = color;
+            encode_frame(glyphs.data(), columns, columns, rows, fg.data(), bad_bg.data(), palette, rle, bytes);
+            CHECK(!frame.parse(bytes.data(), bytes.size()));
+        }
+
+    // Uniform background packs into a couple of runs; a header claiming a
+    // huge grid over those few bytes must fail without the multi-gigabyte
+    // resize, as must cell counts that overflow or do not fit an int.
+    std::vector<byte> bytes;
+    encode_frame(glyphs.data(), columns, columns, rows, fg.data(), bg.data(), palette, true, bytes);
+    FrameHeader header = header_of(bytes);
+    CHECK(header.rle_planes & 4);
+
+    const uint32_t sizes[][2] = {{65536, 65536}, {0xffffffffu, 0xffffffffu}, {0x80000000u, 1}, {columns, rows + 1}};
+    for(const auto& size : sizes) {
+        FrameHeader forged = header;
+        forged.columns = size[0];
+        forged.rows = size[1];
+        set_header(bytes, forged);
+        Frame frame;
+        CHECK(!frame.parse(bytes.data(), bytes.size()));
+        CHECK(frame.storage.capacity() == 0);
+    }
+
+    // Plane sizes that claim more than the file holds.
+    FrameHeader forged = header;
+    forged.plane_sizes[0] = 0xffffffffu;
+    set_header(bytes, forged);
+    Frame frame;
+    CHECK(!frame.parse(bytes.data(), bytes.size()));
+    CHECK(frame.storage.capacity() == 0);
+
+    return check_result("frame");
+}
@@ -0,0 +1,90 @@
+// High-precision input is tone mapped instead of truncated: float .hdr and
+// 16-bit PPM files land in the 8-bit buffer through exposure, the chosen
+// operator and sRGB encoding, alpha included, and the operators themselves
+// map linear values where they should.
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "check.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "../core/image.hpp"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../stb/stb_image_write.h"
+#include "../core/hdr.hpp"
+
+namespace fs = std::filesystem;
+
+static bool near(int value, int expected) { return value >= expected - 1 && value <= expected + 1; }
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / ("asciimage-hdr-test-" + std::to_string(getpid()));
+    fs::create_directories(dir);
+
+    // Operators on linear light: Reinhard halves 1.0, ACES keeps black,
+    // everything is clamped to [0, 1] after exposure.
+    float values[] = {0.0f, 1.0f, 3.0f, -1.0f};
+    tonemap_block(values, 4, ToneMap::REINHARD, 1.0f);
+    CHECK(values[0] == 0.0f && values[1] == 0.5f && values[2] == 0.75f && values[3] == 0.0f);
+    float aces[] = {0.0f, 100.0f};
+    tonemap_block(aces, 2, ToneMap::ACES, 1.0f);
+    CHECK(aces[0] == 0.0f && aces[1] == 1.0f);
+    float exposed[] = {0.25f, 0.8f};
+    tonemap_block(exposed, 2, ToneMap::NONE, 2.0f);
+    CHECK(exposed[0] == 0.5f && exposed[1] == 1.0f);
+
+    // sRGB encoding of linear 0.5 is 188, of 0.214 about 128.
+    const byte* encode = linear_to_srgb_table();
+    CHECK(encode[0] == 0 && encode[SRGB_ENCODE_SIZE - 1] == 255);
+    CHECK(near(encode[SRGB_ENCODE_SIZE / 2], 188));
+
+    // A float image brighter than 1.0 keeps its highlights apart under
+    // Reinhard at a fixed exposure, where plain clamping merges them.
+    std::string hdr_path = (dir / "bright.hdr").string();
+    const float pixels[] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 4.0f, 4.0f, 4.0f, 16.0f, 16.0f, 16.0f};
+    CHECK(stbi_write_hdr(hdr_path.c_str(), 4, 1, 3, pixels));
+    CHECK(is_high_precision(hdr_path));
+    HdrOptions options;
+    options.tonemap = ToneMap::REINHARD;
+    options.exposure = 1.0f;
+    Image image(hdr_path);
+    CHECK(read_high_precision(image, options) && image.width == 4 && image.height == 1);
+    CHECK(image.data[0] == 0 && near(image.data[3], 188) && image.data[6] < image.data[9] && image.data[9] < 255);
+    options.tonemap = ToneMap::NONE;
+    Image clamped(hdr_path);
+    CHECK(read_high_precision(clamped, options) && clamped.data[3] == 255 && clamped.data[9] == 255);
+
+    // 16-bit PPM read as RGBA: sRGB code values map to their 8-bit
+    // neighbours, with no tone operator by default, and alpha is opaque.
+    std::string ppm_path = (dir / "deep.ppm").string();
+    FILE* file = fopen(ppm_path.c_str(), "wb");
+    CHECK(file);
+    if(file) {
+        fprintf(file, "P6\n2 1\n65535\n");
+        const uint16_t words[] = {65535, 32896, 0, 257, 0, 65535};
+        for(uint16_t word : words) {
+            fputc(word >> 8, file);
+            fputc(word & 0xff, file);
+        }
+        fclose(file);
+    }
+    CHECK(stbi_is_16_bit(ppm_path.c_str()));
+    Image deep(ppm_path, 4);
+    CHECK(read_high_precision(deep, HdrOptions()));
+    CHECK(deep.data && deep.width == 2 && deep.height == 1);
+    if(deep.data) {
+        CHECK(deep.data[0] == 255 && near(deep.data[1], 128) && deep.data[2] == 0 && deep.data[3] == 255);
+        CHECK(near(deep.data[4], 1) && deep.data[5] == 0 && deep.data[6] == 255 && deep.data[7] == 255);
+    }
+
+    float exposure = 0.0f;
+    CHECK(parse_exposure("1.5", exposure) && exposure == 1.5f);
+    CHECK(!parse_exposure("0", exposure) && !parse_exposure("-2", exposure) && !parse_exposure("2x", exposure));
+    ToneMap tonemap;
+    CHECK(parse_tonemap("aces", tonemap) && tonemap == ToneMap::ACES && !parse_tonemap("filmic", tonemap));
+
+    fs::remove_all(dir);
+    return check_result("hdr");
+}
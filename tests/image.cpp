@@ -0,0 +1,87 @@
+// Image owns its pixels alone: it cannot be copied, a move hands the buffer
+// over and empties the source, and every buffer stb_image allocates through
+// the installed ImageAllocator is released to it exactly once, even when the
+// allocator is no longer current by then.
+
+#include <filesystem>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <unistd.h>
+#include "check.hpp"
+#include "../core/allocator.hpp"
+#define STBI_MALLOC(size) image_malloc(size)
+#define STBI_REALLOC(p, size) image_realloc(p, size)
+#define STBI_FREE(p) image_free(p)
+#define STB_IMAGE_IMPLEMENTATION
+#include "../core/image.hpp"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../stb/stb_image_write.h"
+
+namespace fs = std::filesystem;
+
+static_assert(!std::is_copy_constructible<Image>::value && !std::is_copy_assignable<Image>::value, "Image is move-only");
+static_assert(std::is_nothrow_move_constructible<Image>::value && std::is_nothrow_move_assignable<Image>::value, "Image moves cannot throw");
+
+// malloc with a count of live blocks.
+class CountingAllocator : public ImageAllocator {
+public:
+    int live = 0, allocations = 0;
+
+    void* allocate(size_t size) override {
+        allocations++;
+        live++;
+        return malloc(size);
+    }
+
+    void release(void* block, size_t) override {
+        live--;
+        free(block);
+    }
+};
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / ("asciimage-image-test-" + std::to_string(getpid()));
+    fs::create_directories(dir);
+    std::string path = (dir / "rgb.png").string();
+    const int width = 5, height = 3;
+    std::vector<unsigned char> pixels(size_t(width) * height * 4);
+    for(size_t i = 0; i < pixels.size(); i++) pixels[i] = static_cast<unsigned char>(i * 13);
+    CHECK(stbi_write_png(path.c_str(), width, height, 4, pixels.data(), 0));
+
+    CountingAllocator counting;
+    Image kept;
+    {
+        UseImageAllocator use(&counting);
+        Image image(path);
+        CHECK(image.read() && image.width == width && image.height == height && image.channels == 3);
+        CHECK(counting.allocations > 0 && counting.live == 1);
+        CHECK(image.data[3] == pixels[4] && image.data[4] == pixels[5]);
+
+        byte* data = image.data;
+        Image moved(std::move(image));
+        CHECK(moved.data == data && !image.data && moved.path == path);
+        kept = std::move(moved);
+        CHECK(kept.data == data && !moved.data && counting.live == 1);
+
+        // Reading again frees the old pixels before decoding new ones.
+        Image rgba(path, 4);
+        CHECK(rgba.read() && rgba.channels == 4 && counting.live == 2);
+        CHECK(rgba.read() && counting.live == 2);
+    }
+    // Outside the scope the default allocator is back, but the kept pixels
+    // still go back to the one that served them.
+    CHECK(current_image_allocator() == nullptr && counting.live == 1);
+    Image unrelated(path);
+    CHECK(unrelated.read() && counting.live == 1);
+    kept = std::move(unrelated);
+    CHECK(counting.live == 0);
+    kept.release();
+    CHECK(!kept.data);
+
+    Image missing((dir / "missing.png").string());
+    CHECK(!missing.read() && !missing.data);
+
+    fs::remove_all(dir);
+    return check_result("image");
+}
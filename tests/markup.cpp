@@ -0,0 +1,48 @@
+// HTML and SVG export of small grids, checked as text: a 2x1 frame gives its
+// palette classes and one span per color run, markup characters are
+// escaped, and SVG draws one rect per background run and trims blank glyphs.
+
+#include <string>
+#include "check.hpp"
+#include "../core/markup.hpp"
+
+static void append(void* context, void* data, int size) {
+    static_cast<std::string*>(context)->append(static_cast<const char*>(data), size);
+}
+
+static bool contains(const std::string& text, const std::string& part) { return text.find(part) != std::string::npos; }
+
+int main() {
+    const RGBA palette[2] = {{0, 0, 0}, {255, 128, 1}};
+
+    {
+        const byte fg[] = {1, 0}, bg[] = {0, 1};
+        std::string html;
+        export_html("<&", 2, 2, 1, fg, bg, palette, 2, append, &html);
+        CHECK(contains(html, ".f1{color:#ff8001}\n.b1{background:#ff8001}\n"));
+        CHECK(contains(html, "<pre class=\"asciimage\"><span class=\"f1 b0\">&lt;</span><span class=\"f0 b1\">&amp;</span>\n</pre>"));
+        CHECK(html.compare(0, 15, "<!DOCTYPE html>") == 0 && html.compare(html.size() - 8, 8, "</html>\n") == 0);
+    }
+
+    {
+        // Equal colors share one span; rows follow `stride`, not columns.
+        const byte fg[] = {1, 1, 0, 0}, bg[] = {0, 0, 0, 0};
+        std::string html;
+        export_html("ab|cd", 3, 2, 2, fg, bg, palette, 2, append, &html);
+        CHECK(contains(html, "<span class=\"f1 b0\">ab</span>\n<span class=\"f0 b0\">cd</span>\n"));
+    }
+
+    {
+        const byte fg[] = {1, 1, 0}, bg[] = {0, 0, 1};
+        std::string svg;
+        export_svg(" a>", 3, 3, 1, fg, bg, palette, 2, append, &svg);
+        CHECK(contains(svg, "width=\"24\" height=\"16\""));
+        CHECK(contains(svg, ".f1{fill:#ff8001}"));
+        CHECK(contains(svg, "<rect class=\"b0\" x=\"0\" y=\"0\" width=\"16\" height=\"16\"/><rect class=\"b1\" x=\"16\" y=\"0\" width=\"8\" height=\"16\"/>"));
+        CHECK(contains(svg, "<text class=\"f1\" x=\"8\" y=\"12\" textLength=\"8\" lengthAdjust=\"spacingAndGlyphs\">a</text>"));
+        CHECK(contains(svg, ">&gt;</text>"));
+        CHECK(svg.compare(svg.size() - 7, 7, "</svg>\n") == 0);
+    }
+
+    return check_result("markup");
+}
@@ -0,0 +1,43 @@
+// PaletteMatcher against a plain scan with oklab_distance, on a full
+// PALETTE_MAX palette so the padded SSE2 path covers every lane.
+
+#include <random>
+#include "check.hpp"
+#include "../core/palette.hpp"
+
+int main() {
+    std::mt19937 random(26);
+    auto channel = [&] { return static_cast<byte>(random() & 0xFF); };
+
+    Palette palette;
+    for(size_t i = 0; i < PALETTE_MAX; i++) palette.entries.push_back({channel(), channel(), channel()});
+    std::vector<Oklab> lab(PALETTE_MAX);
+    std::vector<float> L(PALETTE_MAX), A(PALETTE_MAX), B(PALETTE_MAX);
+    srgb_to_oklab_planes(palette.entries.data(), PALETTE_MAX, L.data(), A.data(), B.data());
+    for(size_t i = 0; i < PALETTE_MAX; i++) lab[i] = {L[i], A[i], B[i]};
+
+    PaletteMatcher matcher(palette);
+    const Oklab* bins = rgb555_oklab_table();
+    for(size_t bin = 0; bin < PALETTE_BINS; bin++) {
+        float best = 1e30f;
+        for(const Oklab& entry : lab) best = std::min(best, oklab_distance(entry, bins[bin]));
+        size_t found = matcher.nearest(bins[bin]);
+        CHECK(found < PALETTE_MAX);
+        CHECK(oklab_distance(lab[found], bins[bin]) == best);
+    }
+
+    // Sizes that leave the last SSE2 step partly padded.
+    for(size_t size : {1, 3, 16, 17}) {
+        Palette small;
+        small.entries.assign(palette.entries.begin(), palette.entries.begin() + size);
+        PaletteMatcher small_matcher(small);
+        for(size_t bin = 0; bin < PALETTE_BINS; bin += 97) {
+            float best = 1e30f;
+            for(size_t i = 0; i < size; i++) best = std::min(best, oklab_distance(lab[i], bins[bin]));
+            size_t found = small_matcher.nearest(bins[bin]);
+            CHECK(found < size);
+            CHECK(oklab_distance(lab[found], bins[bin]) == best);
+        }
+    }
+    return check_result("palette");
+}
@@ -0,0 +1,69 @@
+// PixelPlanes against a plain per-pixel reference: grey, RGB and RGBA input
+// at widths around the 16-pixel vector step (so the SSE2/SSSE3 kernels, the
+// scalar tail and the scalar-only case all run) must give exactly the same
+// R, G, B, A and L, and so must the alpha-weighted box downsample.
+
+#include <cstdlib>
+#include <vector>
+#include "check.hpp"
+#include "../core/planes.hpp"
+
+static RGBA source_pixel(const std::vector<byte>& pixels, int width, int channels, int x, int y) {
+    const byte* p = &pixels[(size_t(y) * width + x) * channels];
+    if(channels == 1) return {p[0], p[0], p[0], 255};
+    return {p[0], p[1], p[2], channels == 4 ? p[3] : static_cast<byte>(255)};
+}
+
+static byte reference_lightness(const RGBA& c) {
+    return static_cast<byte>((c.max_value() + c.min_value()) / 2);
+}
+
+int main() {
+    srand(41);
+    for(int channels : {1, 3, 4})
+        for(int width : {1, 3, 15, 16, 17, 31, 33, 47, 64, 65}) {
+            const int height = 5;
+            std::vector<byte> pixels(size_t(width) * height * channels);
+            for(byte& v : pixels) v = static_cast<byte>(rand());
+
+            PixelPlanes planes;
+            planes.deinterleave(pixels.data(), width, height, channels);
+            bool exact = true;
+            for(int y = 0; y < height; y++)
+                for(int x = 0; x < width; x++) {
+                    RGBA expected = source_pixel(pixels, width, channels, x, y), got = planes.pixel(x, y);
+                    exact &= got.r == expected.r && got.g == expected.g && got.b == expected.b && got.a == expected.a;
+                    exact &= planes.row(CHANNEL_L, y)[x] == reference_lightness(expected);
+                }
+            CHECK(exact);
+
+            const int w = (width + 1) / 2, h = 2;
+            PixelPlanes small;
+            small.downsample(planes, w, h);
+            exact = true;
+            for(int y = 0; y < h; y++)
+                for(int x = 0; x < w; x++) {
+                    int y0 = y * height / h, y1 = std::max(y0 + 1, (y + 1) * height / h);
+                    int x0 = x * width / w, x1 = std::max(x0 + 1, (x + 1) * width / w);
+                    uint64_t r = 0, g = 0, b = 0, alpha = 0;
+                    for(int sy = y0; sy < y1; sy++)
+                        for(int sx = x0; sx < x1; sx++) {
+                            RGBA c = source_pixel(pixels, width, channels, sx, sy);
+                            r += c.r * uint64_t(c.a);
+                            g += c.g * uint64_t(c.a);
+                            b += c.b * uint64_t(c.a);
+                            alpha += c.a;
+                        }
+                    RGBA expected = {
+                        static_cast<byte>(alpha ? r / alpha : 0), static_cast<byte>(alpha ? g / alpha : 0),
+                        static_cast<byte>(alpha ? b / alpha : 0), static_cast<byte>(alpha / (uint64_t(y1 - y0) * (x1 - x0)))
+                    };
+                    RGBA got = small.pixel(x, y);
+                    exact &= got.r == expected.r && got.g == expected.g && got.b == expected.b && got.a == expected.a;
+                    exact &= small.row(CHANNEL_L, y)[x] == reference_lightness(got);
+                }
+            CHECK(exact);
+        }
+
+    return check_result("planes");
+}
@@ -0,0 +1,65 @@
+// png_deflate round trips through stb_image's inflater, with matches at the
+// shortest distance (1), just inside the window (32767) and at its very edge
+// (32768, the last distance deflate can code), at every kind of level and
+// with one and several strips.
+
+#include <random>
+#include "check.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "../core/image.hpp"
+#include "../core/png.hpp"
+
+// `period` random bytes repeated until `size`: every later byte matches the
+// one exactly `period` back.
+static std::vector<unsigned char> repeating(size_t period, size_t size, std::mt19937& random) {
+    std::vector<unsigned char> data(size);
+    for(size_t i = 0; i < size; i++) data[i] = i < period ? static_cast<unsigned char>(random()) : data[i - period];
+    return data;
+}
+
+int main() {
+    std::mt19937 random(36);
+    const size_t size = size_t(1) << 18; // four strips of 64 KiB each
+    // The fraction of its size each input must at least shrink to when the
+    // level searches for matches; the noise inputs only compress through the
+    // repeat, so this also shows the edge distances are really used. Strips
+    // restart the window, so half of each 64 KiB strip stays literal.
+    struct Case {
+        std::vector<unsigned char> data;
+        double ratio;
+    };
+    std::vector<Case> cases = {
+        {repeating(1, size, random), 0.01},
+        {repeating(32767, size, random), 0.6},
+        {repeating(32768, size, random), 0.6},
+        {repeating(32768, 65536, random), 0.6}, // the reported case: 32 KiB of noise, twice
+        {{}, 1.0},
+    };
+
+    for(const Case& test : cases) {
+        const std::vector<unsigned char>& input = test.data;
+        for(int level : {0, 1, 6, 9}) {
+            for(int strips : {1, 4}) {
+                png_deflate_strips() = strips;
+                std::vector<unsigned char> copy = input;
+                int compressed_size = 0;
+                unsigned char* compressed = png_deflate(copy.data(), static_cast<int>(copy.size()), &compressed_size, level);
+                CHECK(compressed != nullptr);
+                if(!compressed) continue;
+
+                int decoded_size = -1;
+                char* decoded = stbi_zlib_decode_malloc(reinterpret_cast<const char*>(compressed), compressed_size, &decoded_size);
+                CHECK(decoded != nullptr);
+                CHECK(decoded_size == static_cast<int>(input.size()));
+                if(decoded && decoded_size == static_cast<int>(input.size()))
+                    CHECK(input.empty() || memcmp(decoded, input.data(), input.size()) == 0);
+                if(level > 0 && !input.empty())
+                    CHECK(compressed_size < input.size() * test.ratio);
+                free(decoded);
+                free(compressed);
+            }
+        }
+    }
+    png_deflate_strips() = 1;
+    return check_result("png");
+}
@@ -0,0 +1,69 @@
+// shape_ascii_image keys cells through ShapeLayout and banded prefix sums;
+// it must pick the same glyphs as summing and dividing each region of each
+// block directly, for any cell size and tone curve.
+
+#include <random>
+#include "check.hpp"
+#include "../core/shape.hpp"
+
+static uint32_t reference_key(const byte* lightness, int stride, int cell, const ToneCurve& curve) {
+    uint32_t key = 0;
+    for(int ry = 0; ry < SHAPE_GRID; ry++) {
+        int y0 = ry * cell / SHAPE_GRID, y1 = (ry + 1) * cell / SHAPE_GRID;
+        for(int rx = 0; rx < SHAPE_GRID; rx++) {
+            int x0 = rx * cell / SHAPE_GRID, x1 = (rx + 1) * cell / SHAPE_GRID;
+            uint32_t sum = 0;
+            for(int y = y0; y < y1; y++)
+                for(int x = x0; x < x1; x++) sum += curve[lightness[size_t(y) * stride + x]];
+            uint32_t area = (x1 - x0) * (y1 - y0);
+            key |= (sum * (SHAPE_LEVELS - 1) + area * 127) / (255 * area) << ((ry * SHAPE_GRID + rx) * SHAPE_BITS);
+        }
+    }
+    return key;
+}
+
+int main() {
+    std::mt19937 random(32);
+
+    // Random 6x9 glyph bitmaps under distinct printable names.
+    GlyphSet set;
+    set.cell_width = 6;
+    set.cell_height = 9;
+    for(char c = '!'; c <= '~'; c++) set.glyphs += c;
+    set.bitmaps.resize(set.glyphs.size() * set.cell_size());
+    for(byte& v : set.bitmaps) v = random() & 1 ? 255 : 0;
+
+    ToneCurve inverted;
+    for(int i = 0; i < 256; i++) inverted[i] = static_cast<byte>(255 - i);
+
+    const int width = 203, height = 97;
+    std::vector<byte> lightness(size_t(width) * height);
+    for(int image = 0; image < 4; image++) {
+        // Smooth ramps keep many regions near the level boundaries; noise
+        // covers the rest of the key space.
+        for(int y = 0; y < height; y++)
+            for(int x = 0; x < width; x++)
+                lightness[size_t(y) * width + x] = image & 1 ? static_cast<byte>(random()) : static_cast<byte>((x * 255 / width + y * (image + 1)) & 0xFF);
+
+        for(const ToneCurve& curve : {identity_curve(), inverted}) {
+            for(int cell : {3, 4, 5, 7, 8, 16}) {
+                ShapeMatcher matcher(set), reference(set);
+                std::string output = shape_ascii_image(lightness.data(), width, height, cell, matcher, curve);
+
+                int columns = width / cell, rows = height / cell;
+                std::string expected;
+                for(int row = 0; row < rows; row++) {
+                    if(row) expected += '\n';
+                    for(int column = 0; column < columns; column++)
+                        expected += reference.match(reference_key(&lightness[size_t(row) * cell * width + column * cell], width, cell, curve));
+                }
+                CHECK(output == expected);
+            }
+        }
+    }
+
+    // Too small for a single cell.
+    ShapeMatcher matcher(set);
+    CHECK(shape_ascii_image(lightness.data(), 2, 2, 3, matcher, identity_curve()).empty());
+    return check_result("shape");
+}
@@ -0,0 +1,54 @@
+// probe_terminal reads color support from the environment alone: NO_COLOR,
+// a missing or dumb TERM and a stdout that is not a tty turn color off,
+// COLORTERM or a *-direct TERM ask for RGB and *256color* for the xterm
+// table. Screen mode without color sends glyphs and cursor moves only.
+
+#include <string>
+#include "check.hpp"
+#include "../platform/console.hpp"
+
+static ColorSupport probe(const char* term, const char* colorterm = nullptr, const char* no_color = nullptr, bool tty = true) {
+    auto set = [](const char* name, const char* value) {
+        if(value) setenv(name, value, 1);
+        else unsetenv(name);
+    };
+    set("TERM", term);
+    set("COLORTERM", colorterm);
+    set("NO_COLOR", no_color);
+    return probe_terminal(tty).colors;
+}
+
+static void append(void* context, void* data, int size) {
+    static_cast<std::string*>(context)->append(static_cast<const char*>(data), size);
+}
+
+int main() {
+    CHECK(probe("xterm") == ColorSupport::BASIC);
+    CHECK(probe("xterm-256color") == ColorSupport::XTERM256);
+    CHECK(probe("screen-256color-bce") == ColorSupport::XTERM256);
+    CHECK(probe("xterm-direct") == ColorSupport::TRUECOLOR);
+    CHECK(probe("xterm", "truecolor") == ColorSupport::TRUECOLOR);
+    CHECK(probe("xterm-256color", "24bit") == ColorSupport::TRUECOLOR);
+    CHECK(probe("xterm", "yes") == ColorSupport::BASIC);
+
+    CHECK(probe(nullptr) == ColorSupport::NONE);
+    CHECK(probe("") == ColorSupport::NONE);
+    CHECK(probe("dumb", "truecolor") == ColorSupport::NONE);
+    CHECK(probe("xterm-256color", "truecolor", "1") == ColorSupport::NONE);
+    CHECK(probe("xterm-256color", nullptr, "") == ColorSupport::XTERM256);
+    CHECK(probe("xterm-256color", "truecolor", nullptr, false) == ColorSupport::NONE);
+    CHECK(!probe_terminal(false).tty && probe_terminal(true).tty);
+
+    const char glyphs[] = "abcd";
+    const CellAttr attrs[] = {cell_attr(1, 2), cell_attr(3, 4), cell_attr(3, 4), cell_attr(5, 6)};
+    const RGBA palette[16] = {};
+    std::string out;
+    AnsiScreen screen(append, &out);
+    screen.present(glyphs, attrs, 2, 2, palette, ColorSupport::NONE);
+    CHECK(out == ANSI_SYNC_BEGIN "\x1b[1;1Hab\x1b[2;1Hcd" ANSI_SYNC_END);
+    out.clear();
+    screen.present(glyphs, attrs, 2, 2, palette, ColorSupport::BASIC);
+    CHECK(out.find("\x1b[34;42ma") != std::string::npos && out.find("\x1b[0m") != std::string::npos);
+
+    return check_result("terminal");
+}
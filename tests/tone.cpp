@@ -0,0 +1,51 @@
+// Tone curves: equalization spreads a two-level image over the whole range
+// and always takes the brightest occupied level to 255, auto levels stretch
+// the occupied range, every curve is monotonic, and the threaded histogram
+// counts what a single pass does.
+
+#include <cstdlib>
+#include <vector>
+#include "check.hpp"
+#include "../core/tone.hpp"
+
+static bool monotonic(const ToneCurve& curve) {
+    for(size_t v = 1; v < 256; v++)
+        if(curve[v] < curve[v - 1]) return false;
+    return true;
+}
+
+int main() {
+    Histogram two_levels = {};
+    two_levels[60] = 500;
+    two_levels[90] = 500;
+    ToneCurve curve = equalize(two_levels);
+    CHECK(curve[60] == 0 && curve[90] == 255);
+    CHECK(curve[0] == 0 && curve[255] == 255 && monotonic(curve));
+
+    // Clipping leaves a remainder of the excess unspread; the top still reaches 255.
+    Histogram skewed = {};
+    skewed[10] = 100000;
+    for(int v = 11; v < 200; v += 3) skewed[v] = 7;
+    curve = equalize(skewed);
+    CHECK(curve[10] == 0 && curve[199] == 255 && monotonic(curve));
+    CHECK(curve[100] > 0 && curve[100] < 255);
+
+    Histogram single = {};
+    single[128] = 10;
+    CHECK(equalize(single) == identity_curve());
+    CHECK(equalize(Histogram{}) == identity_curve());
+
+    curve = auto_levels(two_levels);
+    CHECK(curve[60] == 0 && curve[90] == 255 && curve[75] == 127 && monotonic(curve));
+
+    Tone tone;
+    CHECK(parse_tone("equalize", tone) && tone == Tone::EQUALIZE);
+    CHECK(!parse_tone("gamma", tone));
+
+    std::vector<byte> plane(size_t(1) << 21);
+    Histogram expected = {};
+    for(byte& v : plane) expected[v = static_cast<byte>(rand() % 251)]++;
+    CHECK(lightness_histogram(plane.data(), plane.size()) == expected);
+
+    return check_result("tone");
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+// The console's 16 attribute colors, with no Windows dependency, so code that
+// only names colors builds on every platform.
+enum Color {
+    BLACK, BLUE, GREEN, AQUA, RED, PURPLE, YELLOW, WHITE,
+    GRAY, GREY = GRAY,
+    LIGHT_BLUE, LIGHT_GREEN, LIGHT_AQUA, LIGHT_RED,
+    LIGHT_PURPLE, LIGHT_YELLOW, LIGHT_WHITE,
+    AUTO
+};
+
+constexpr size_t CONSOLE_COLORS = 16;
+
+inline const char* Color_cstr(Color color) {
+    switch(color) {
+        case BLACK: return "BLACK"; case BLUE: return "BLUE";
+        case GREEN: return "GREEN"; case AQUA: return "AQUA";
+        case RED: return "RED"; case PURPLE: return "PURPLE";
+        case YELLOW: return "YELLOW"; case WHITE: return "WHITE";
+        case GRAY: return "GREY";
+        case LIGHT_BLUE: return "LIGHT_BLUE"; case LIGHT_GREEN: return "LIGHT_GREEN";
+        case LIGHT_AQUA: return "LIGHT_AQUA"; case LIGHT_RED: return "LIGHT_RED";
+        case LIGHT_PURPLE: return "LIGHT_PURPLE"; case LIGHT_YELLOW: return "LIGHT_YELLOW";
+        case LIGHT_WHITE: return "LIGHT_WHITE"; case AUTO: return "AUTO";
+        default: return "UNKNOWN";
+    }
+}
+
+struct COLORS {
+    Color fore = AUTO;
+    Color back = AUTO;
+};
@@ -0,0 +1,309 @@
+#pragma once
+
+// Stand-in for the console part of <windows.h> off Windows, enough for
+// winsole.hpp and frame.hpp to compile anywhere. Calls land in
+// mock_console(), which keeps a screen of CHAR_INFO cells, the current text
+// attribute and a count of every call, so console code can be exercised and
+// its API traffic measured without a console. For tests only: include it
+// before winsole.hpp; nothing in the program does.
+
+#define WINSOLE_MOCK 1
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <vector>
+
+typedef void* HANDLE;
+typedef unsigned short WORD;
+typedef unsigned long DWORD;
+typedef unsigned long ULONG;
+typedef unsigned int UINT;
+typedef int BOOL;
+typedef short SHORT;
+typedef wchar_t WCHAR;
+typedef DWORD COLORREF;
+
+#ifndef WINAPI
+    #define WINAPI
+#endif
+
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+#define STD_OUTPUT_HANDLE ((DWORD)-11)
+#define STD_INPUT_HANDLE ((DWORD)-10)
+#define GENERIC_READ 0x80000000L
+#define GENERIC_WRITE 0x40000000L
+#define CONSOLE_TEXTMODE_BUFFER 1
+#define LF_FACESIZE 32
+#define FW_NORMAL 400
+#define CP_UTF8 65001
+#define RGB(r, g, b) ((COLORREF)(((unsigned char)(r) | ((WORD)((unsigned char)(g)) << 8)) | (((DWORD)(unsigned char)(b)) << 16)))
+
+struct COORD {
+    SHORT X, Y;
+};
+
+struct SMALL_RECT {
+    SHORT Left, Top, Right, Bottom;
+};
+
+struct CHAR_INFO {
+    union {
+        WCHAR UnicodeChar;
+        char AsciiChar;
+    } Char;
+    WORD Attributes;
+};
+
+struct CONSOLE_SCREEN_BUFFER_INFOEX {
+    ULONG cbSize;
+    COORD dwSize;
+    COORD dwCursorPosition;
+    WORD wAttributes;
+    SMALL_RECT srWindow;
+    COORD dwMaximumWindowSize;
+    WORD wPopupAttributes;
+    BOOL bFullscreenSupported;
+    COLORREF ColorTable[16];
+};
+
+struct CONSOLE_FONT_INFOEX {
+    ULONG cbSize;
+    DWORD nFont;
+    COORD dwFontSize;
+    UINT FontFamily;
+    UINT FontWeight;
+    WCHAR FaceName[LF_FACESIZE];
+};
+
+// Number of calls made to each console function.
+struct MockCalls {
+    size_t set_text_attribute = 0;
+    size_t write_console = 0;
+    size_t write_output = 0;
+    size_t fill_output = 0;
+    size_t set_cursor = 0;
+    size_t set_info = 0;
+    size_t set_active_buffer = 0;
+    size_t create_buffer = 0;
+
+    size_t total() const {
+        return set_text_attribute + write_console + write_output + fill_output + set_cursor + set_info + set_active_buffer + create_buffer;
+    }
+};
+
+// One console with a single screen buffer; every handle draws on it. As on
+// a real console the buffer keeps scrollback: it is taller than the window,
+// which shows `window` (inclusive) of it and follows the cursor down.
+struct MockConsole {
+    SHORT width = 120, height = 300;
+    std::vector<CHAR_INFO> screen = std::vector<CHAR_INFO>(size_t(120) * 300);
+    SMALL_RECT window = {0, 0, 119, 29};
+    COORD cursor = {0, 0};
+    WORD attribute = 0x07;
+    COLORREF palette[16] = {};
+    MockCalls calls;
+    // WriteConsoleOutputA regions that reached past the screen; the real
+    // call clips them, but well-behaved callers do not send them.
+    size_t offscreen_writes = 0;
+
+    // A fresh w x h buffer with the window at its top, window_rows tall (the
+    // whole buffer if 0).
+    void resize(SHORT w, SHORT h, SHORT window_rows = 0) {
+        width = w;
+        height = h;
+        screen.assign(size_t(w) * h, CHAR_INFO());
+        SHORT rows = window_rows > 0 && window_rows < h ? window_rows : h;
+        window = {0, 0, static_cast<SHORT>(w - 1), static_cast<SHORT>(rows - 1)};
+        cursor = {0, 0};
+    }
+
+    void reset_calls() {
+        calls = MockCalls();
+        offscreen_writes = 0;
+    }
+
+    const CHAR_INFO& at(int x, int y) const { return screen[size_t(y) * width + x]; }
+
+    // Scrolls the window down just far enough to show the cursor.
+    void follow_cursor() {
+        SHORT rows = window.Bottom - window.Top;
+        if(cursor.Y > window.Bottom) {
+            window.Bottom = cursor.Y;
+            window.Top = cursor.Y - rows;
+        } else if(cursor.Y < window.Top) {
+            window.Top = cursor.Y;
+            window.Bottom = cursor.Y + rows;
+        }
+    }
+
+    // A new line past the last row scrolls the whole buffer up by one.
+    void new_line() {
+        cursor.X = 0;
+        if(cursor.Y + 1 < height) {
+            cursor.Y++;
+        } else {
+            screen.erase(screen.begin(), screen.begin() + width);
+            screen.resize(size_t(width) * height, CHAR_INFO());
+        }
+        follow_cursor();
+    }
+
+    void put(char c) {
+        if(c == '\n') {
+            new_line();
+            return;
+        }
+        CHAR_INFO& cell = screen[size_t(cursor.Y) * width + cursor.X];
+        cell.Char.AsciiChar = c;
+        cell.Attributes = attribute;
+        if(++cursor.X == width) new_line();
+    }
+};
+
+inline MockConsole& mock_console() {
+    static MockConsole console;
+    return console;
+}
+
+inline HANDLE WINAPI GetStdHandle(DWORD) {
+    return &mock_console();
+}
+
+inline BOOL WINAPI GetConsoleScreenBufferInfoEx(HANDLE, CONSOLE_SCREEN_BUFFER_INFOEX* info) {
+    MockConsole& console = mock_console();
+    info->dwSize = {console.width, console.height};
+    info->dwCursorPosition = console.cursor;
+    info->wAttributes = console.attribute;
+    info->srWindow = console.window;
+    info->dwMaximumWindowSize = {static_cast<SHORT>(console.window.Right - console.window.Left + 1), static_cast<SHORT>(console.window.Bottom - console.window.Top + 1)};
+    info->wPopupAttributes = console.attribute;
+    info->bFullscreenSupported = 0;
+    memcpy(info->ColorTable, console.palette, sizeof(console.palette));
+    return 1;
+}
+
+// Applies the buffer size (keeping the rows that still fit), cursor and
+// palette, as the real call does; the window is left where it is.
+inline BOOL WINAPI SetConsoleScreenBufferInfoEx(HANDLE, CONSOLE_SCREEN_BUFFER_INFOEX* info) {
+    MockConsole& console = mock_console();
+    console.calls.set_info++;
+    if(info->dwSize.X != console.width || info->dwSize.Y != console.height) {
+        std::vector<CHAR_INFO> screen(size_t(info->dwSize.X) * info->dwSize.Y);
+        for(int y = 0; y < info->dwSize.Y && y < console.height; y++)
+            for(int x = 0; x < info->dwSize.X && x < console.width; x++)
+                screen[size_t(y) * info->dwSize.X + x] = console.at(x, y);
+        console.screen.swap(screen);
+        console.width = info->dwSize.X;
+        console.height = info->dwSize.Y;
+    }
+    console.cursor = info->dwCursorPosition;
+    memcpy(console.palette, info->ColorTable, sizeof(console.palette));
+    return 1;
+}
+
+inline COORD WINAPI GetLargestConsoleWindowSize(HANDLE) {
+    return {mock_console().width, mock_console().height};
+}
+
+inline BOOL WINAPI SetConsoleTextAttribute(HANDLE, WORD attribute) {
+    mock_console().calls.set_text_attribute++;
+    mock_console().attribute = attribute;
+    return 1;
+}
+
+inline BOOL WINAPI WriteConsoleA(HANDLE, const void* text, DWORD length, DWORD* written, void*) {
+    MockConsole& console = mock_console();
+    console.calls.write_console++;
+    for(DWORD i = 0; i < length; i++) console.put(static_cast<const char*>(text)[i]);
+    if(written) *written = length;
+    return 1;
+}
+#define WriteConsole WriteConsoleA
+
+// Copies the part of `buffer` starting at `from` into `region`, clipped to
+// the screen, and reports the clipped region back like the real call.
+inline BOOL WINAPI WriteConsoleOutputA(HANDLE, const CHAR_INFO* buffer, COORD size, COORD from, SMALL_RECT* region) {
+    MockConsole& console = mock_console();
+    console.calls.write_output++;
+    if(region->Right >= console.width || region->Bottom >= console.height) console.offscreen_writes++;
+    if(region->Right >= console.width) region->Right = console.width - 1;
+    if(region->Bottom >= console.height) region->Bottom = console.height - 1;
+    for(int y = region->Top; y <= region->Bottom; y++) {
+        int source_y = from.Y + (y - region->Top);
+        if(source_y >= size.Y) break;
+        for(int x = region->Left; x <= region->Right; x++) {
+            int source_x = from.X + (x - region->Left);
+            if(source_x >= size.X) break;
+            console.screen[size_t(y) * console.width + x] = buffer[size_t(source_y) * size.X + source_x];
+        }
+    }
+    return 1;
+}
+
+inline BOOL WINAPI FillConsoleOutputCharacter(HANDLE, WCHAR c, DWORD length, COORD at, DWORD* written) {
+    MockConsole& console = mock_console();
+    console.calls.fill_output++;
+    size_t start = size_t(at.Y) * console.width + at.X;
+    for(size_t i = start; i < start + length && i < console.screen.size(); i++) console.screen[i].Char.AsciiChar = static_cast<char>(c);
+    if(written) *written = length;
+    return 1;
+}
+
+inline BOOL WINAPI FillConsoleOutputAttribute(HANDLE, WORD attribute, DWORD length, COORD at, DWORD* written) {
+    MockConsole& console = mock_console();
+    console.calls.fill_output++;
+    size_t start = size_t(at.Y) * console.width + at.X;
+    for(size_t i = start; i < start + length && i < console.screen.size(); i++) console.screen[i].Attributes = attribute;
+    if(written) *written = length;
+    return 1;
+}
+
+inline BOOL WINAPI SetConsoleCursorPosition(HANDLE, COORD at) {
+    MockConsole& console = mock_console();
+    console.calls.set_cursor++;
+    if(at.X < 0 || at.Y < 0 || at.X >= console.width || at.Y >= console.height) return 0;
+    console.cursor = at;
+    console.follow_cursor();
+    return 1;
+}
+
+inline HANDLE WINAPI CreateConsoleScreenBuffer(DWORD, DWORD, const void*, DWORD, void*) {
+    mock_console().calls.create_buffer++;
+    return &mock_console();
+}
+
+inline BOOL WINAPI SetConsoleActiveScreenBuffer(HANDLE) {
+    mock_console().calls.set_active_buffer++;
+    return 1;
+}
+
+inline BOOL WINAPI CloseHandle(HANDLE) { return 1; }
+inline BOOL WINAPI FreeConsole() { return 1; }
+
+inline BOOL WINAPI GetCurrentConsoleFontEx(HANDLE, BOOL, CONSOLE_FONT_INFOEX* info) {
+    info->nFont = 0;
+    info->dwFontSize = {8, 16};
+    info->FontFamily = 0;
+    info->FontWeight = FW_NORMAL;
+    info->FaceName[0] = 0;
+    return 1;
+}
+
+inline BOOL WINAPI SetCurrentConsoleFontEx(HANDLE, BOOL, CONSOLE_FONT_INFOEX*) { return 1; }
+inline COORD WINAPI GetConsoleFontSize(HANDLE, DWORD) { return {8, 16}; }
+
+// Plain byte widening; enough for ASCII names.
+inline int WINAPI MultiByteToWideChar(UINT, DWORD, const char* text, int length, WCHAR* out, int capacity) {
+    int count = length < 0 ? static_cast<int>(strlen(text)) + 1 : length;
+    if(!out) return count;
+    for(int i = 0; i < count && i < capacity; i++) out[i] = static_cast<unsigned char>(text[i]);
+    return count < capacity ? count : capacity;
+}
+
+inline int wcsncpy_s(WCHAR* out, const WCHAR* text, size_t count) {
+    wcsncpy(out, text, count);
+    out[count] = 0;
+    return 0;
+}
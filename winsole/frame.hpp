@@ -0,0 +1,49 @@
+#pragma once
+
+#ifdef _WIN32
+    #include <windows.h>
+#elif !defined(WINSOLE_MOCK)
+    #error "Winsole needs <windows.h>; elsewhere include console_mock.hpp first (tests only)."
+#endif
+#include <cstddef>
+#include <vector>
+
+// WriteConsoleOutput rejects buffers much past 64 KB, so frames are sent in
+// bands of whole rows of at most this many (4-byte) cells. An 80x25 or
+// 120x50 console still goes out in a single call.
+constexpr int BLIT_MAX_CELLS = 16000;
+
+// Packs a glyph plane and an attribute plane (fg | bg << 4 per cell, as in
+// wAttributes), both columns x rows, into CHAR_INFO cells.
+inline void build_frame(const char* glyphs, const unsigned char* attrs, int columns, int rows, std::vector<CHAR_INFO>& frame) {
+    size_t cells = size_t(columns) * rows;
+    frame.resize(cells);
+    for(size_t i = 0; i < cells; i++) {
+        frame[i].Char.UnicodeChar = 0;
+        frame[i].Char.AsciiChar = glyphs[i];
+        frame[i].Attributes = attrs[i];
+    }
+}
+
+// Writes a columns x rows frame with its top left corner at `origin`,
+// clipped to a `screen` sized buffer: cells past its edges are never sent,
+// and bands that would land wholly below it are not written at all. Each
+// band is one WriteConsoleOutputA call. A frame wider than a COORD can
+// describe goes out a row at a time, each row as a buffer of its own.
+inline bool blit_frame(HANDLE handle, const CHAR_INFO* frame, int columns, int rows, COORD origin, COORD screen) {
+    int visible_columns = columns < screen.X - origin.X ? columns : screen.X - origin.X;
+    int visible_rows = rows < screen.Y - origin.Y ? rows : screen.Y - origin.Y;
+    if(visible_columns <= 0 || visible_rows <= 0) return true;
+    bool wide = columns > 0x7FFF;
+    int band_rows = visible_columns < BLIT_MAX_CELLS && !wide ? BLIT_MAX_CELLS / visible_columns : 1;
+    bool ok = true;
+    for(int y = 0; y < visible_rows; y += band_rows) {
+        int height = visible_rows - y < band_rows ? visible_rows - y : band_rows;
+        COORD size = {static_cast<SHORT>(wide ? visible_columns : columns), static_cast<SHORT>(height)};
+        COORD from = {0, 0};
+        SMALL_RECT region = {origin.X, static_cast<SHORT>(origin.Y + y),
+                             static_cast<SHORT>(origin.X + visible_columns - 1), static_cast<SHORT>(origin.Y + y + height - 1)};
+        ok = WriteConsoleOutputA(handle, frame + size_t(y) * columns, size, from, &region) && ok;
+    }
+    return ok;
+}
@@ -1,44 +1,22 @@
 #pragma once
 
-#include <windows.h>
+#ifdef _WIN32
+    #include <windows.h>
+#elif !defined(WINSOLE_MOCK)
+    #error "Winsole needs <windows.h>; elsewhere include console_mock.hpp first (tests only)."
+#endif
 #include <cstdio>
 #include <cwchar>
 #include <cstring>
 #include <string>
 #include <vector>
+#include "colors.hpp"
+#include "frame.hpp"
 
 #ifdef NEEDS_REDEFINE
     #include "winapi_tools.hpp"
 #endif
 
-enum Color {
-    BLACK, BLUE, GREEN, AQUA, RED, PURPLE, YELLOW, WHITE,
-    GRAY, GREY = GRAY,
-    LIGHT_BLUE, LIGHT_GREEN, LIGHT_AQUA, LIGHT_RED,
-    LIGHT_PURPLE, LIGHT_YELLOW, LIGHT_WHITE,
-    AUTO
-};
-
-inline const char* Color_cstr(Color color) {
-    switch(color) {
-        case BLACK: return "BLACK"; case BLUE: return "BLUE";
-        case GREEN: return "GREEN"; case AQUA: return "AQUA";
-        case RED: return "RED"; case PURPLE: return "PURPLE";
-        case YELLOW: return "YELLOW"; case WHITE: return "WHITE";
-        case GRAY: return "GREY";
-        case LIGHT_BLUE: return "LIGHT_BLUE"; case LIGHT_GREEN: return "LIGHT_GREEN";
-        case LIGHT_AQUA: return "LIGHT_AQUA"; case LIGHT_RED: return "LIGHT_RED";
-        case LIGHT_PURPLE: return "LIGHT_PURPLE"; case LIGHT_YELLOW: return "LIGHT_YELLOW";
-        case LIGHT_WHITE: return "LIGHT_WHITE"; case AUTO: return "AUTO";
-        default: return "UNKNOWN";
-    }
-}
-
-struct COLORS {
-    Color fore = AUTO;
-    Color back = AUTO;
-};
-
 using cwstr = const wchar_t*;
 
 inline std::wstring wide(const char* cstr) {
@@ -69,7 +47,7 @@ public:
 private:
     HANDLE handle = nullptr;
     bool max_window = false;
-    CONSOLE_FONT_INFOEX info = { sizeof(CONSOLE_FONT_INFOEX) };
+    CONSOLE_FONT_INFOEX info = {}; // cbSize set by init()
 };
 
 inline bool Font::init(HANDLE handle, bool max_window) {
@@ -112,13 +90,14 @@ inline bool Font::update() {
 class Winsole {
 public:
     Winsole() = default;
-    Winsole(const Winsole&) = default;
-    Winsole(Winsole&&) noexcept = default;
+    Winsole(const Winsole&) = delete;
+    Winsole& operator=(const Winsole&) = delete;
     ~Winsole();
 
     bool init();
     COORD get_max_raw_size() const;
     const SMALL_RECT& get_raw_size() const;
+    const SMALL_RECT& get_window() const;
     const COORD& get_size() const;
 
     Color get_foreground() const;
@@ -128,20 +107,50 @@ public:
     void set_size(const COORD& size);
     void set_raw_size(const SMALL_RECT& size);
     bool set_colors(const COLORS& colors);
+    bool set_palette(const COLORREF* table, size_t count);
 
     void put(char c, const COLORS& colors);
     void print(const char* cstr, const COLORS& colors);
+    bool print_runs(const char* glyphs, const unsigned char* attrs, size_t count);
+    void begin_batch();
+    void end_batch();
+    bool restore_colors();
+    bool blit(const char* glyphs, const unsigned char* attrs, int columns, int rows);
     bool clear();
     bool update();
 
+    bool double_buffer();
+    bool flip();
+    void single_buffer();
+
     HANDLE get_handle() const;
 
 private:
+    // Not a valid attribute: the next set_attribute() always reaches the console.
+    static constexpr WORD NO_ATTRIBUTE = 0xFFFF;
+
+    bool set_attribute(WORD attrs);
+    void sync_position();
+
     HANDLE handle = nullptr;
-    CONSOLE_SCREEN_BUFFER_INFOEX info = { sizeof(CONSOLE_SCREEN_BUFFER_INFOEX) };
+    CONSOLE_SCREEN_BUFFER_INFOEX info = {}; // cbSize set by init()
+    // The visible part of the buffer as the console reports it (inclusive);
+    // info.srWindow holds it in the form update() writes back.
+    SMALL_RECT window = {};
+    std::vector<CHAR_INFO> frame;
+    WORD attribute = NO_ATTRIBUTE;
+    int batch = 0;
+    HANDLE output = nullptr;
+    HANDLE buffers[2] = {nullptr, nullptr};
+    int back = 0;
 };
 
 inline Winsole::~Winsole() {
+    if(batch) {
+        batch = 0;
+        restore_colors();
+    }
+    single_buffer();
     if(handle && handle != INVALID_HANDLE_VALUE) {
         FreeConsole();
     }
@@ -155,14 +164,31 @@ inline bool Winsole::init() {
     info.cbSize = sizeof(info);
     if (!GetConsoleScreenBufferInfoEx(handle, &info))
         return false;
+    attribute = info.wAttributes;
+    window = info.srWindow;
 
+    // SetConsoleScreenBufferInfoEx shrinks the window by a row and a column
+    // on every round trip; stored one larger, update() keeps it as it is.
+    // dwSize stays the real buffer size, scrollback included.
     info.srWindow.Bottom += 1;
     info.srWindow.Right += 1;
-    info.dwSize.Y = info.srWindow.Bottom;
-    info.dwSize.X = info.srWindow.Right;
     return true;
 }
 
+// The cursor and window move as the console is written to and scrolled;
+// brought up to date before update() writes them back, so it does not
+// jump them to where they were at init().
+inline void Winsole::sync_position() {
+    CONSOLE_SCREEN_BUFFER_INFOEX now = {};
+    now.cbSize = sizeof(now);
+    if(!GetConsoleScreenBufferInfoEx(handle, &now)) return;
+    window = now.srWindow;
+    info.dwCursorPosition = now.dwCursorPosition;
+    info.srWindow = now.srWindow;
+    info.srWindow.Bottom += 1;
+    info.srWindow.Right += 1;
+}
+
 inline HANDLE Winsole::get_handle() const {
     return handle;
 }
@@ -175,6 +201,10 @@ inline const SMALL_RECT& Winsole::get_raw_size() const {
     return info.srWindow;
 }
 
+inline const SMALL_RECT& Winsole::get_window() const {
+    return window;
+}
+
 inline const COORD& Winsole::get_size() const {
     return info.dwMaximumWindowSize;
 }
@@ -202,29 +232,112 @@ inline void Winsole::set_raw_size(const SMALL_RECT& size) {
     info.dwSize.Y = size.Bottom + 1;
 }
 
+// The last attribute set is remembered, so asking for the colors already in
+// effect costs no console call.
+inline bool Winsole::set_attribute(WORD attrs) {
+    if(attrs == attribute) return true;
+    if(!SetConsoleTextAttribute(handle, attrs)) {
+        attribute = NO_ATTRIBUTE;
+        return false;
+    }
+    attribute = attrs;
+    return true;
+}
+
 inline bool Winsole::set_colors(const COLORS& colors) {
     if(!handle || handle == INVALID_HANDLE_VALUE) return false;
     WORD attrs = info.wAttributes;
     if (colors.fore != AUTO) attrs = (attrs & 0xF0) | (colors.fore & 0x0F);
     if (colors.back != AUTO) attrs = (attrs & 0x0F) | ((colors.back & 0x0F) << 4);
-    return SetConsoleTextAttribute(handle, attrs);
+    return set_attribute(attrs);
+}
+
+// Back to the colors the console had at init().
+inline bool Winsole::restore_colors() {
+    if(!handle || handle == INVALID_HANDLE_VALUE) return false;
+    return set_attribute(info.wAttributes);
+}
+
+// Between begin_batch() and end_batch(), put/print/print_runs leave their
+// colors set instead of restoring them after every call; the restore happens
+// once, at the end.
+inline void Winsole::begin_batch() {
+    batch++;
+}
+
+inline void Winsole::end_batch() {
+    if(batch > 0 && --batch == 0) restore_colors();
+}
+
+inline bool Winsole::set_palette(const COLORREF* table, size_t count) {
+    if(!handle || handle == INVALID_HANDLE_VALUE) return false;
+    for(size_t i = 0; i < count && i < CONSOLE_COLORS; i++)
+        info.ColorTable[i] = table[i];
+    sync_position();
+    return update();
 }
 
 inline void Winsole::put(char c, const COLORS& colors) {
-    COLORS last = get_colors();
     if(set_colors(colors)) {
         DWORD written;
         WriteConsoleA(handle, &c, 1, &written, nullptr);
     }
-    set_colors(last);
+    if(!batch) restore_colors();
 }
 
 inline void Winsole::print(const char* cstr, const COLORS& colors) {
-    COLORS last = get_colors();
     set_colors(colors);
     DWORD written;
     WriteConsoleA(handle, cstr, static_cast<DWORD>(strlen(cstr)), &written, nullptr);
-    set_colors(last);
+    if(!batch) restore_colors();
+}
+
+// Prints `count` glyphs at the cursor, each with its packed attribute
+// (fg | bg << 4). Cells are grouped into runs of equal attributes: one
+// attribute change, if any, and one write per run.
+inline bool Winsole::print_runs(const char* glyphs, const unsigned char* attrs, size_t count) {
+    if(!handle || handle == INVALID_HANDLE_VALUE) return false;
+    bool ok = true;
+    for(size_t start = 0, end; start < count; start = end) {
+        for(end = start + 1; end < count && attrs[end] == attrs[start]; end++) {}
+        DWORD written;
+        ok = set_attribute(attrs[start]) && ok;
+        ok = WriteConsoleA(handle, glyphs + start, static_cast<DWORD>(end - start), &written, nullptr) && ok;
+    }
+    if(!batch) restore_colors();
+    return ok;
+}
+
+// Draws a whole grid of cells: one CHAR_INFO buffer, kept between calls, and
+// as few WriteConsoleOutputA calls as it allows. Like printed text the frame
+// starts on the cursor's line (the next one if the cursor is mid-line), the
+// buffer scrolls up first if the frame would run past its end, and the
+// cursor ends up on the line below it. After double_buffer() the frame fills
+// the window instead and the cursor stays. Whatever falls outside the buffer
+// is clipped off.
+inline bool Winsole::blit(const char* glyphs, const unsigned char* attrs, int columns, int rows) {
+    if(!handle || handle == INVALID_HANDLE_VALUE) return false;
+    CONSOLE_SCREEN_BUFFER_INFOEX now = {};
+    now.cbSize = sizeof(now);
+    if(!GetConsoleScreenBufferInfoEx(handle, &now)) return false;
+    build_frame(glyphs, attrs, columns, rows, frame);
+    if(buffers[0]) return blit_frame(handle, frame.data(), columns, rows, {0, now.srWindow.Top}, now.dwSize);
+
+    int last = now.dwSize.Y - 1;
+    int top = now.dwCursorPosition.Y + (now.dwCursorPosition.X ? 1 : 0);
+    int scroll = top + rows - last;
+    if(scroll > top) scroll = top;
+    bool ok = true;
+    if(scroll > 0) {
+        std::string lines(scroll, '\n');
+        DWORD written;
+        ok = SetConsoleCursorPosition(handle, {0, static_cast<SHORT>(last)}) &&
+             WriteConsoleA(handle, lines.data(), static_cast<DWORD>(lines.size()), &written, nullptr);
+        top -= scroll;
+    }
+    ok = blit_frame(handle, frame.data(), columns, rows, {0, static_cast<SHORT>(top)}, now.dwSize) && ok;
+    int below = top + rows < last ? top + rows : last;
+    return SetConsoleCursorPosition(handle, {0, static_cast<SHORT>(below)}) && ok;
 }
 
 inline bool Winsole::clear() {
@@ -242,3 +355,53 @@ inline bool Winsole::clear() {
 inline bool Winsole::update() {
     return SetConsoleScreenBufferInfoEx(handle, &info);
 }
+
+// Draws into a hidden screen buffer from now on. Two buffers shaped like the
+// current one are created; everything (blit, print, clear...) goes to the
+// back one until flip() shows it, so a frame is never seen half drawn.
+inline bool Winsole::double_buffer() {
+    if(!handle || handle == INVALID_HANDLE_VALUE) return false;
+    if(buffers[0]) return true;
+
+    CONSOLE_SCREEN_BUFFER_INFOEX shape = {};
+    shape.cbSize = sizeof(shape);
+    if(!GetConsoleScreenBufferInfoEx(handle, &shape)) return false;
+    for(HANDLE& buffer : buffers) {
+        buffer = CreateConsoleScreenBuffer(GENERIC_READ | GENERIC_WRITE, 0, nullptr, CONSOLE_TEXTMODE_BUFFER, nullptr);
+        if(buffer == INVALID_HANDLE_VALUE || !SetConsoleScreenBufferInfoEx(buffer, &shape)) {
+            if(buffer == INVALID_HANDLE_VALUE) buffer = nullptr;
+            single_buffer();
+            return false;
+        }
+    }
+    output = handle;
+    back = 0;
+    handle = buffers[back];
+    attribute = NO_ATTRIBUTE;
+    return true;
+}
+
+// Shows the back buffer and starts drawing into the other one.
+inline bool Winsole::flip() {
+    if(!buffers[0]) return true;
+    if(!SetConsoleActiveScreenBuffer(buffers[back])) return false;
+    back ^= 1;
+    handle = buffers[back];
+    attribute = NO_ATTRIBUTE;
+    return true;
+}
+
+// Goes back to the original buffer, which still holds what was on screen
+// before double_buffer().
+inline void Winsole::single_buffer() {
+    if(output) {
+        SetConsoleActiveScreenBuffer(output);
+        handle = output;
+        output = nullptr;
+        attribute = NO_ATTRIBUTE;
+    }
+    for(HANDLE& buffer : buffers) {
+        if(buffer) CloseHandle(buffer);
+        buffer = nullptr;
+    }
+}